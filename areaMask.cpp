@@ -0,0 +1,439 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "areaMask.hpp"
+
+#include <algorithm>
+
+
+//  Most vertices we'll get back from get_area_mbr (.ARE and .afs files).
+
+#define         AREA_MAX_VERTICES               200
+
+
+//  A polygon edge in the edge table.  x is the column (in cell center units) where the edge crosses row first_row
+//  and dx is the change in x from one row to the next.
+
+typedef struct
+{
+  double           x, dx;
+  int32_t          first_row, last_row, shape;
+} AREA_EDGE;
+
+
+//  Inside cells first through end - 1 of a row.
+
+typedef struct
+{
+  int32_t          first, end;
+} AREA_SPAN;
+
+
+//  Orders the edge table by starting row.
+
+static bool edge_row_less (const AREA_EDGE &a, const AREA_EDGE &b)
+{
+  return (a.first_row < b.first_row);
+}
+
+
+//  Orders the active edges by shape and then by crossing.
+
+static bool edge_x_less (const AREA_EDGE &a, const AREA_EDGE &b)
+{
+  if (a.shape != b.shape) return (a.shape < b.shape);
+
+  return (a.x < b.x);
+}
+
+
+//  Orders spans by their first cell.
+
+static bool span_less (const AREA_SPAN &a, const AREA_SPAN &b)
+{
+  return (a.first < b.first);
+}
+
+
+
+areaMask::areaMask ()
+{
+  width = num_shapes = 0;
+  memset (&mbr, 0, sizeof (NV_F64_XYMBR));
+}
+
+
+
+void areaMask::clear ()
+{
+  x.clear ();
+  y.clear ();
+  ring_start.clear ();
+  ring_shape.clear ();
+  span_col.clear ();
+  row_start.clear ();
+
+  width = num_shapes = 0;
+  memset (&mbr, 0, sizeof (NV_F64_XYMBR));
+}
+
+
+
+//!  Add a ring of "count" vertices to shape "shape" and extend the MBR to include it.
+
+void areaMask::addRing (double *px, double *py, int32_t count, int32_t shape)
+{
+  if (ring_start.isEmpty ())
+    {
+      ring_start.append (0);
+
+      mbr.min_x = mbr.max_x = px[0];
+      mbr.min_y = mbr.max_y = py[0];
+    }
+
+
+  for (int32_t i = 0 ; i < count ; i++)
+    {
+      x.append (px[i]);
+      y.append (py[i]);
+
+      mbr.min_x = qMin (mbr.min_x, px[i]);
+      mbr.max_x = qMax (mbr.max_x, px[i]);
+      mbr.min_y = qMin (mbr.min_y, py[i]);
+      mbr.max_y = qMax (mbr.max_y, py[i]);
+    }
+
+  ring_start.append (x.size ());
+  ring_shape.append (shape);
+}
+
+
+
+//!  Read every part of every shape in an ESRI Polygon or PolyLine shape file.
+
+int32_t areaMask::readShape (char *area_name)
+{
+  SHPHandle shpHandle;
+  SHPObject *shape;
+  int32_t numShapes, type;
+  double minBounds[4], maxBounds[4];
+
+
+  shpHandle = SHPOpen (area_name, "rb");
+
+  if (shpHandle == NULL)
+    {
+      error_string = QObject::tr ("Cannot open shape file");
+      return (-1);
+    }
+
+
+  SHPGetInfo (shpHandle, &numShapes, &type, minBounds, maxBounds);
+
+  if (type != SHPT_POLYGON && type != SHPT_POLYGONZ && type != SHPT_POLYGONM &&
+      type != SHPT_ARC && type != SHPT_ARCZ && type != SHPT_ARCM)
+    {
+      SHPClose (shpHandle);
+      error_string = QObject::tr ("Shape file is not a polygon or polyline file");
+      return (-1);
+    }
+
+
+  for (int32_t i = 0 ; i < numShapes ; i++)
+    {
+      shape = SHPReadObject (shpHandle, i);
+
+      if (shape == NULL) continue;
+
+
+      for (int32_t part = 0 ; part < shape->nParts ; part++)
+        {
+          int32_t start = shape->panPartStart[part];
+          int32_t end = (part + 1 < shape->nParts) ? shape->panPartStart[part + 1] : shape->nVertices;
+
+          if (end - start >= 3) addRing (&shape->padfX[start], &shape->padfY[start], end - start, num_shapes);
+        }
+
+
+      //  Older shape files may not have parts.
+
+      if (!shape->nParts && shape->nVertices >= 3) addRing (shape->padfX, shape->padfY, shape->nVertices, num_shapes);
+
+
+      SHPDestroyObject (shape);
+
+      num_shapes++;
+    }
+
+  SHPClose (shpHandle);
+
+
+  if (ring_start.isEmpty ())
+    {
+      error_string = QObject::tr ("Shape file doesn't contain a polygon with at least 3 vertices");
+      return (-1);
+    }
+
+
+  return (0);
+}
+
+
+
+/*!
+  Read the polygons from an area file.  Shape files are read here, the other area file types are read with
+  get_area_mbr.  Returns 0 on success or -1 (see errorString) on failure.
+*/
+
+int32_t areaMask::read (char *area_name)
+{
+  clear ();
+
+
+  if (QString (area_name).endsWith (".shp", Qt::CaseInsensitive)) return (readShape (area_name));
+
+
+  int32_t count = 0;
+  double polygon_x[AREA_MAX_VERTICES], polygon_y[AREA_MAX_VERTICES];
+  NV_F64_XYMBR area_mbr;
+
+  if (!get_area_mbr (area_name, &count, polygon_x, polygon_y, &area_mbr))
+    {
+      error_string = QString (strerror (errno));
+      return (-1);
+    }
+
+
+  //  A rectangle may come back as just its corners.
+
+  if (count < 3)
+    {
+      polygon_x[0] = polygon_x[3] = area_mbr.min_x;
+      polygon_x[1] = polygon_x[2] = area_mbr.max_x;
+      polygon_y[0] = polygon_y[1] = area_mbr.min_y;
+      polygon_y[2] = polygon_y[3] = area_mbr.max_y;
+      count = 4;
+    }
+
+  addRing (polygon_x, polygon_y, count, 0);
+  num_shapes = 1;
+
+
+  return (0);
+}
+
+
+
+/*!
+  Rasterize the rings into inside spans for a window of cols by rows cells whose southwest corner is at min_x,
+  min_y.  Each edge is put in the edge table at the first row whose cell center it crosses (an edge covers the
+  rows from its low end up to, but not including, its high end so a vertex is only counted once).  Going north,
+  one row at a time, edges are added to the active list as they start and dropped when they end, the active
+  edges are sorted by shape and crossing, and the crossings are paired up within each shape.  The spans from all
+  of the shapes are then merged so overlapping shapes don't cancel each other.
+*/
+
+void areaMask::build (double min_x, double min_y, double x_cell_degrees, double y_cell_degrees, int32_t cols, int32_t rows)
+{
+  QVector<AREA_EDGE> edges, active;
+  QVector<AREA_SPAN> row_spans;
+
+
+  width = cols;
+
+  span_col.clear ();
+  row_start.resize (rows + 1);
+
+
+  //  Build the edge table in cell center units (cell i's center is at i).
+
+  for (int32_t r = 0 ; r < ring_start.size () - 1 ; r++)
+    {
+      int32_t start = ring_start[r], count = ring_start[r + 1] - ring_start[r];
+
+      for (int32_t i = 0 ; i < count ; i++)
+        {
+          int32_t a = start + i, b = start + (i + 1) % count;
+
+          double xa = (x[a] - min_x) / x_cell_degrees - 0.5;
+          double ya = (y[a] - min_y) / y_cell_degrees - 0.5;
+          double xb = (x[b] - min_x) / x_cell_degrees - 0.5;
+          double yb = (y[b] - min_y) / y_cell_degrees - 0.5;
+
+
+          //  Horizontal edges never cross a row center.
+
+          if (ya == yb) continue;
+
+          if (ya > yb)
+            {
+              std::swap (xa, xb);
+              std::swap (ya, yb);
+            }
+
+
+          AREA_EDGE edge;
+
+          edge.first_row = qMax (0, (int32_t) ceil (ya));
+          edge.last_row = qMin (rows - 1, (int32_t) ceil (yb) - 1);
+
+          if (edge.first_row > edge.last_row) continue;
+
+          edge.dx = (xb - xa) / (yb - ya);
+          edge.x = xa + ((double) edge.first_row - ya) * edge.dx;
+          edge.shape = ring_shape[r];
+
+          edges.append (edge);
+        }
+    }
+
+  std::sort (edges.begin (), edges.end (), edge_row_less);
+
+
+  int32_t next_edge = 0;
+
+  for (int32_t row = 0 ; row < rows ; row++)
+    {
+      //  Drop the edges that ended on the last row and add the ones that start on this one.
+
+      int32_t kept = 0;
+      for (int32_t i = 0 ; i < active.size () ; i++)
+        {
+          if (active[i].last_row >= row) active[kept++] = active[i];
+        }
+      active.resize (kept);
+
+      while (next_edge < edges.size () && edges[next_edge].first_row == row) active.append (edges[next_edge++]);
+
+      std::sort (active.begin (), active.end (), edge_x_less);
+
+
+      //  Pair up the crossings of each shape.
+
+      row_spans.clear ();
+
+      for (int32_t i = 0 ; i + 1 < active.size () ; )
+        {
+          if (active[i].shape != active[i + 1].shape)
+            {
+              i++;
+              continue;
+            }
+
+          AREA_SPAN span;
+          span.first = (int32_t) qBound (0.0, ceil (active[i].x), (double) cols);
+          span.end = (int32_t) qBound (0.0, ceil (active[i + 1].x), (double) cols);
+
+          if (span.end > span.first) row_spans.append (span);
+
+          i += 2;
+        }
+
+
+      //  Merge the spans (they only overlap when the shapes do).
+
+      row_start[row] = span_col.size ();
+
+      std::sort (row_spans.begin (), row_spans.end (), span_less);
+
+      for (int32_t i = 0 ; i < row_spans.size () ; i++)
+        {
+          int32_t last = span_col.size () - 1;
+
+          if (span_col.size () > row_start[row] && row_spans[i].first <= span_col[last])
+            {
+              span_col[last] = qMax (span_col[last], row_spans[i].end);
+            }
+          else
+            {
+              span_col.append (row_spans[i].first);
+              span_col.append (row_spans[i].end);
+            }
+        }
+
+
+      for (int32_t i = 0 ; i < active.size () ; i++) active[i].x += active[i].dx;
+    }
+
+  row_start[rows] = span_col.size ();
+}
+
+
+
+//!  Set every cell of row "row" (0 is the southernmost row) that isn't in one of its spans to null_value.
+
+void areaMask::apply (int32_t row, float *dest, float null_value)
+{
+  applySegment (row, 0, width, dest, null_value);
+}
+
+
+
+/*!
+  Set every cell of columns first through first + count - 1 of row "row" that isn't in one of its spans to
+  null_value.  dest[0] is column "first".
+*/
+
+void areaMask::applySegment (int32_t row, int32_t first, int32_t count, float *dest, float null_value)
+{
+  int32_t col = first, end = first + count;
+
+  for (int32_t s = row_start[row] ; s < row_start[row + 1] && col < end ; s += 2)
+    {
+      for ( ; col < qMin (span_col[s], end) ; col++) dest[col - first] = null_value;
+
+      col = qMax (col, span_col[s + 1]);
+    }
+
+  for ( ; col < end ; col++) dest[col - first] = null_value;
+}
+
+
+
+//!  Returns NVTrue if columns first through end - 1 of row "row" are all inside the mask.
+
+uint8_t areaMask::covers (int32_t row, int32_t first, int32_t end)
+{
+  for (int32_t s = row_start[row] ; s < row_start[row + 1] ; s += 2)
+    {
+      if (span_col[s] <= first && span_col[s + 1] >= end) return (NVTrue);
+      if (span_col[s] > first) break;
+    }
+
+  return (NVFalse);
+}
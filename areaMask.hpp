@@ -0,0 +1,99 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef AREAMASK_H
+#define AREAMASK_H
+
+#include "chrtrGeotiffDef.hpp"
+
+
+/*!
+  Polygon mask for the output window.  read loads the polygons from an area file (.ARE, .afs, or an ESRI Polygon
+  or PolyLine shape file, PolyLines being closed from their last point back to their first).  Every shape in a
+  shape file is used, not just the first one, and each part of a shape is a ring so holes work.  build then
+  rasterizes the rings with an edge table scanline fill into spans of inside cells for each row of the window.
+
+  A cell is inside when its center is.  Inside a shape the rings are filled even/odd, the shapes are combined
+  (a cell inside any of them is inside the mask).  Rows are numbered from the south like
+  chrtrRenderEngine::loadRow.
+*/
+
+class areaMask
+{
+public:
+
+  areaMask ();
+
+  int32_t read (char *area_name);
+  void build (double min_x, double min_y, double x_cell_degrees, double y_cell_degrees, int32_t cols, int32_t rows);
+  void clear ();
+  void apply (int32_t row, float *dest, float null_value);
+  void applySegment (int32_t row, int32_t first, int32_t count, float *dest, float null_value);
+  uint8_t covers (int32_t row, int32_t first, int32_t end);
+
+  uint8_t active () {return (!row_start.isEmpty ());};
+  uint8_t empty (int32_t row) {return (row_start[row] == row_start[row + 1]);};
+  int32_t spans (int32_t row) {return ((row_start[row + 1] - row_start[row]) / 2);};
+  int32_t shapes () {return (num_shapes);};
+  NV_F64_XYMBR bounds () {return (mbr);};
+  QString errorString () {return (error_string);};
+
+
+protected:
+
+  int32_t readShape (char *area_name);
+  void addRing (double *px, double *py, int32_t count, int32_t shape);
+
+
+  QVector<double>  x, y;                    //!<  Ring vertices, ring i is ring_start[i] through ring_start[i + 1] - 1
+
+  QVector<int32_t> ring_start, ring_shape;
+
+  QVector<int32_t> span_col;                //!<  Start and end (one past the last inside cell) column of each span
+
+  QVector<int32_t> row_start;               //!<  First span_col entry for each row (rows + 1 entries)
+
+  NV_F64_XYMBR     mbr;
+
+  int32_t          width, num_shapes;
+
+  QString          error_string;
+};
+
+
+#endif
@@ -0,0 +1,586 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "chrtrRenderEngine.hpp"
+#include "contourSink.hpp"
+#include "version.hpp"
+
+#include <getopt.h>
+
+
+void set_defaults (OPTIONS *options);
+
+
+
+//!  Progress callbacks for chrtrRenderEngine in batch mode.  We only print every 10 percent so we don't flood the log.
+
+class batchProgress : public renderProgress
+{
+public:
+
+  batchProgress ()
+  {
+    steps = 0;
+    percent = -1;
+  };
+
+
+  void stageStart (int32_t stage, int32_t num_steps)
+  {
+    static const char *stage_name[3] = {"Reading grid", "Writing GeoTIFF", "Generating contours"};
+
+    steps = num_steps;
+    percent = -1;
+
+    fprintf (stderr, "%s\n", stage_name[stage]);
+  };
+
+
+  void stageProgress (int32_t stage __attribute__ ((unused)), int32_t step)
+  {
+    if (steps <= 0) return;
+
+    int32_t new_percent = (int32_t) (((int64_t) step * 100) / steps);
+
+    if (new_percent / 10 != percent / 10)
+      {
+        fprintf (stderr, "%3d%%\r", new_percent);
+        fflush (stderr);
+      }
+
+    percent = new_percent;
+
+    if (step == steps) fprintf (stderr, "\n");
+  };
+
+
+  void message (QString string)
+  {
+    fprintf (stderr, "%s\n", string.toLatin1 ().constData ());
+  };
+
+
+protected:
+
+  int32_t steps, percent;
+};
+
+
+/*!
+  Copy a file name from the command line into one of our 512 byte name buffers.  The output name may get ".tif"
+  added (here or in chrtrRenderEngine::createOutput) so every name has to leave room for that.  Returns -1 (after
+  printing an error) if the name is too long.
+*/
+
+static int32_t copy_name (char *dest, const char *src)
+{
+  if (strlen (src) > 507)
+    {
+      fprintf (stderr, "File name is too long (507 characters at most) : %s\n", src);
+      return (-1);
+    }
+
+  strcpy (dest, src);
+
+  return (0);
+}
+
+
+
+static void usage ()
+{
+  fprintf (stderr, "\nUsage: chrtrGeotiff --batch [OPTIONS] CHRTR_FILE [CHRTR_FILE ...]\n\n");
+  fprintf (stderr, "Converts one or more CHRTR (.fin) or CHRTR2 (.ch2) files to GeoTIFF without the GUI.\n");
+  fprintf (stderr, "Options default to the program defaults, not the saved GUI settings.\n\n");
+  fprintf (stderr, "  -o, --output FILE         Output GeoTIFF (only with a single input, default is CHRTR_FILE.tif)\n");
+  fprintf (stderr, "  -a, --area FILE           Optional area file (.are, .afs, or .shp)\n");
+  fprintf (stderr, "      --transparent         Empty cells are transparent\n");
+  fprintf (stderr, "      --caris               Brain-dead Caris output format (PACKBITS)\n");
+  fprintf (stderr, "      --cog                 Cloud Optimized GeoTIFF output (overrides --caris)\n");
+  fprintf (stderr, "      --codec CODEC         lzw (default), deflate, zstd, or lzma (ignored with --caris)\n");
+  fprintf (stderr, "      --level N             Compression level (0 for the codec default)\n");
+  fprintf (stderr, "      --tiled               Tiled GeoTIFF output (ignored with --caris)\n");
+  fprintf (stderr, "      --tile-width N        Tile width in pixels (multiple of 16, default 256)\n");
+  fprintf (stderr, "      --tile-height N       Tile height in pixels (multiple of 16, default 256)\n");
+  fprintf (stderr, "      --overviews           Build internal overviews (ignored with --caris)\n");
+  fprintf (stderr, "      --no-overviews        Don't build internal overviews (default)\n");
+  fprintf (stderr, "      --overview-color M    Color overview resampling, nearest (default) or average\n");
+  fprintf (stderr, "      --overview-grey M     Grey scale overview resampling, nearest or average (default)\n");
+  fprintf (stderr, "      --grey                32 bit floating point output\n");
+  fprintf (stderr, "      --units UNITS         meters or fathoms\n");
+  fprintf (stderr, "      --dumb                Convert to fathoms at 4800 ft/sec\n");
+  fprintf (stderr, "      --elev                Output as elevations instead of depths\n");
+  fprintf (stderr, "      --interval CINT       Contour interval (0.0 for no contours)\n");
+  fprintf (stderr, "      --contour-format FMT  Contour file format, shp (default), gpkg, or fgb\n");
+  fprintf (stderr, "      --restart             Restart the color map at zero (default)\n");
+  fprintf (stderr, "      --no-restart          Color map is continuous from minimum to maximum\n");
+  fprintf (stderr, "      --azimuth DEG         Sun azimuth (0.0-360.0)\n");
+  fprintf (stderr, "      --elevation DEG       Sun elevation (0.0-90.0)\n");
+  fprintf (stderr, "      --exaggeration EX     Sun Z exaggeration\n");
+  fprintf (stderr, "      --saturation SAT      Color saturation (0.0-1.0)\n");
+  fprintf (stderr, "      --value VAL           Color value (0.0-1.0)\n");
+  fprintf (stderr, "      --start-hue HUE       Start hue (0.0-360.0)\n");
+  fprintf (stderr, "      --end-hue HUE         End hue (0.0-360.0)\n");
+  fprintf (stderr, "      --stream              Don't load the whole grid into memory (ignored with --interval)\n");
+  fprintf (stderr, "      --grid-cache          Save the loaded grid in (or map it from) the grid cache\n");
+  fprintf (stderr, "      --cache-dir DIR       Grid cache directory (implies --grid-cache)\n");
+  fprintf (stderr, "      --stats-index         Get the min/max from (and build) the .stats index file (with --stream)\n");
+  fprintf (stderr, "  -t, --threads N           Number of render threads (default 0, all cores)\n");
+  fprintf (stderr, "      --compress-threads N  Number of compression threads (default 0, all cores)\n");
+  fprintf (stderr, "  -h, --help                This message\n\n");
+}
+
+
+
+/***************************************************************************\
+*                                                                           *
+*   Module Name:        batch                                               *
+*                                                                           *
+*   Purpose:            Command line (no GUI) version of chrtrGeotiff.  We  *
+*                       take all of the OPTIONS that surfacePage and        *
+*                       imagePage would normally set as arguments and run   *
+*                       chrtrRenderEngine for each input file.  No widgets  *
+*                       get built and we never call processEvents.  A file  *
+*                       that fails doesn't stop the rest of the files.      *
+*                                                                           *
+*   Return Value:       0 if all files were converted, -1 otherwise         *
+*                                                                           *
+\***************************************************************************/
+
+int32_t batch (int32_t argc, char **argv)
+{
+  enum
+  {
+    OPT_TRANSPARENT = 256,
+    OPT_CARIS,
+    OPT_GREY,
+    OPT_UNITS,
+    OPT_DUMB,
+    OPT_ELEV,
+    OPT_INTERVAL,
+    OPT_RESTART,
+    OPT_NO_RESTART,
+    OPT_AZIMUTH,
+    OPT_ELEVATION,
+    OPT_EXAGGERATION,
+    OPT_SATURATION,
+    OPT_VALUE,
+    OPT_START_HUE,
+    OPT_END_HUE,
+    OPT_STREAM,
+    OPT_TILED,
+    OPT_TILE_WIDTH,
+    OPT_TILE_HEIGHT,
+    OPT_OVERVIEWS,
+    OPT_COG,
+    OPT_COMPRESS_THREADS,
+    OPT_CODEC,
+    OPT_LEVEL,
+    OPT_NO_OVERVIEWS,
+    OPT_CONTOUR_FORMAT,
+    OPT_GRID_CACHE,
+    OPT_CACHE_DIR,
+    OPT_STATS_INDEX,
+    OPT_OVERVIEW_COLOR,
+    OPT_OVERVIEW_GREY,
+    OPT_BATCH
+  };
+
+
+  static struct option long_options[] =
+    {
+      {"batch", no_argument, 0, OPT_BATCH},
+      {"output", required_argument, 0, 'o'},
+      {"area", required_argument, 0, 'a'},
+      {"transparent", no_argument, 0, OPT_TRANSPARENT},
+      {"caris", no_argument, 0, OPT_CARIS},
+      {"cog", no_argument, 0, OPT_COG},
+      {"codec", required_argument, 0, OPT_CODEC},
+      {"level", required_argument, 0, OPT_LEVEL},
+      {"tiled", no_argument, 0, OPT_TILED},
+      {"tile-width", required_argument, 0, OPT_TILE_WIDTH},
+      {"tile-height", required_argument, 0, OPT_TILE_HEIGHT},
+      {"overviews", no_argument, 0, OPT_OVERVIEWS},
+      {"no-overviews", no_argument, 0, OPT_NO_OVERVIEWS},
+      {"overview-color", required_argument, 0, OPT_OVERVIEW_COLOR},
+      {"overview-grey", required_argument, 0, OPT_OVERVIEW_GREY},
+      {"grey", no_argument, 0, OPT_GREY},
+      {"units", required_argument, 0, OPT_UNITS},
+      {"dumb", no_argument, 0, OPT_DUMB},
+      {"elev", no_argument, 0, OPT_ELEV},
+      {"interval", required_argument, 0, OPT_INTERVAL},
+      {"contour-format", required_argument, 0, OPT_CONTOUR_FORMAT},
+      {"restart", no_argument, 0, OPT_RESTART},
+      {"no-restart", no_argument, 0, OPT_NO_RESTART},
+      {"azimuth", required_argument, 0, OPT_AZIMUTH},
+      {"elevation", required_argument, 0, OPT_ELEVATION},
+      {"exaggeration", required_argument, 0, OPT_EXAGGERATION},
+      {"saturation", required_argument, 0, OPT_SATURATION},
+      {"value", required_argument, 0, OPT_VALUE},
+      {"start-hue", required_argument, 0, OPT_START_HUE},
+      {"end-hue", required_argument, 0, OPT_END_HUE},
+      {"stream", no_argument, 0, OPT_STREAM},
+      {"grid-cache", no_argument, 0, OPT_GRID_CACHE},
+      {"cache-dir", required_argument, 0, OPT_CACHE_DIR},
+      {"stats-index", no_argument, 0, OPT_STATS_INDEX},
+      {"threads", required_argument, 0, 't'},
+      {"compress-threads", required_argument, 0, OPT_COMPRESS_THREADS},
+      {"help", no_argument, 0, 'h'},
+      {0, 0, 0, 0}
+    };
+
+
+  char output_name[512], area_name[512], chrtr_name[512];
+  int32_t c, status = 0;
+
+
+  //  OPTIONS holds a QPixmap and a QFont so it has to be allocated after the QCoreApplication is built (in main).
+
+  OPTIONS *options = new OPTIONS;
+
+  set_defaults (options);
+
+  output_name[0] = area_name[0] = 0;
+
+
+  while ((c = getopt_long (argc, argv, "o:a:t:h", long_options, NULL)) != -1)
+    {
+      switch (c)
+        {
+        case OPT_BATCH:
+          break;
+
+        case 'o':
+          if (copy_name (output_name, optarg))
+            {
+              delete options;
+              return (-1);
+            }
+          break;
+
+        case 'a':
+          if (copy_name (area_name, optarg))
+            {
+              delete options;
+              return (-1);
+            }
+          break;
+
+        case OPT_TRANSPARENT:
+          options->transparent = NVTrue;
+          break;
+
+        case OPT_CARIS:
+          options->caris = NVTrue;
+          break;
+
+        case OPT_COG:
+          options->cog = NVTrue;
+          break;
+
+        case OPT_CODEC:
+          options->codec = -1;
+          for (int32_t i = CODEC_LZW ; i <= CODEC_LZMA ; i++)
+            {
+              if (!strcasecmp (optarg, chrtrRenderEngine::codecName (i))) options->codec = i;
+            }
+
+          if (options->codec < 0)
+            {
+              fprintf (stderr, "Codec must be lzw, deflate, zstd, or lzma, not %s\n", optarg);
+              delete options;
+              return (-1);
+            }
+          break;
+
+        case OPT_LEVEL:
+          options->codec_level = atoi (optarg);
+          break;
+
+        case OPT_TILED:
+          options->tiled = NVTrue;
+          break;
+
+        case OPT_TILE_WIDTH:
+          options->tile_width = atoi (optarg);
+          break;
+
+        case OPT_TILE_HEIGHT:
+          options->tile_height = atoi (optarg);
+          break;
+
+        case OPT_OVERVIEWS:
+          options->overviews = NVTrue;
+          break;
+
+        case OPT_NO_OVERVIEWS:
+          options->overviews = NVFalse;
+          break;
+
+        case OPT_OVERVIEW_COLOR:
+        case OPT_OVERVIEW_GREY:
+            {
+              int32_t resampling = -1;
+
+              if (!strcasecmp (optarg, "nearest")) resampling = OVERVIEW_NEAREST;
+              if (!strcasecmp (optarg, "average")) resampling = OVERVIEW_AVERAGE;
+
+              if (resampling < 0)
+                {
+                  fprintf (stderr, "Overview resampling must be nearest or average, not %s\n", optarg);
+                  delete options;
+                  return (-1);
+                }
+
+              if (c == OPT_OVERVIEW_COLOR)
+                {
+                  options->ov_color_resampling = resampling;
+                }
+              else
+                {
+                  options->ov_grey_resampling = resampling;
+                }
+            }
+          break;
+
+        case OPT_GREY:
+          options->grey = NVTrue;
+          break;
+
+        case OPT_UNITS:
+          if (!strcmp (optarg, "meters"))
+            {
+              options->units = 0;
+            }
+          else if (!strcmp (optarg, "fathoms"))
+            {
+              options->units = 1;
+            }
+          else
+            {
+              fprintf (stderr, "Units must be meters or fathoms, not %s\n", optarg);
+              delete options;
+              return (-1);
+            }
+          break;
+
+        case OPT_DUMB:
+          options->dumb = NVTrue;
+          break;
+
+        case OPT_ELEV:
+          options->elev = NVTrue;
+          break;
+
+        case OPT_INTERVAL:
+          options->cint = (float) atof (optarg);
+          break;
+
+        case OPT_CONTOUR_FORMAT:
+          options->contour_format = -1;
+          for (int32_t i = CONTOUR_SHAPEFILE ; i <= CONTOUR_FGB ; i++)
+            {
+              if (!strcasecmp (optarg, &contourSink::extension (i)[1])) options->contour_format = i;
+            }
+
+          if (options->contour_format < 0)
+            {
+              fprintf (stderr, "Contour format must be shp, gpkg, or fgb, not %s\n", optarg);
+              delete options;
+              return (-1);
+            }
+          break;
+
+        case OPT_RESTART:
+          options->restart = NVTrue;
+          break;
+
+        case OPT_NO_RESTART:
+          options->restart = NVFalse;
+          break;
+
+        case OPT_AZIMUTH:
+          options->azimuth = atof (optarg);
+          break;
+
+        case OPT_ELEVATION:
+          options->elevation = atof (optarg);
+          break;
+
+        case OPT_EXAGGERATION:
+          options->exaggeration = atof (optarg);
+          break;
+
+        case OPT_SATURATION:
+          options->saturation = atof (optarg);
+          break;
+
+        case OPT_VALUE:
+          options->value = atof (optarg);
+          break;
+
+        case OPT_START_HUE:
+          options->start_hsv = atof (optarg);
+          break;
+
+        case OPT_END_HUE:
+          options->end_hsv = atof (optarg);
+          break;
+
+        case OPT_STREAM:
+          options->stream = NVTrue;
+          break;
+
+        case OPT_GRID_CACHE:
+          options->grid_cache = NVTrue;
+          break;
+
+        case OPT_CACHE_DIR:
+          options->cache_dir = QString (optarg);
+          options->grid_cache = NVTrue;
+          break;
+
+        case OPT_STATS_INDEX:
+          options->stats_index = NVTrue;
+          break;
+
+        case 't':
+          options->num_threads = atoi (optarg);
+          break;
+
+        case OPT_COMPRESS_THREADS:
+          options->compress_threads = atoi (optarg);
+          break;
+
+        case 'h':
+          usage ();
+          delete options;
+          return (0);
+
+        default:
+          usage ();
+          delete options;
+          return (-1);
+        }
+    }
+
+
+  //  GDAL requires tile dimensions that are multiples of 16.
+
+  if (options->tiled && (options->tile_width < 16 || options->tile_height < 16 || options->tile_width % 16 || options->tile_height % 16))
+    {
+      fprintf (stderr, "Tile width and height must be multiples of 16\n");
+      delete options;
+      return (-1);
+    }
+
+
+  //  The dumb flag only means something if we're outputting fathoms (see surfacePage.cpp).
+
+  if (!options->units) options->dumb = NVFalse;
+
+
+  if (optind >= argc)
+    {
+      usage ();
+      delete options;
+      return (-1);
+    }
+
+  if (output_name[0] && argc - optind > 1)
+    {
+      fprintf (stderr, "--output may only be used with a single input file\n");
+      delete options;
+      return (-1);
+    }
+
+
+  uint8_t contour = NVFalse;
+  if (options->cint != 0.0) contour = NVTrue;
+
+
+  fprintf (stderr, "%s\n", VERSION);
+
+
+  for (int32_t i = optind ; i < argc ; i++)
+    {
+      if (copy_name (chrtr_name, argv[i]))
+        {
+          status = -1;
+          continue;
+        }
+
+      if (strstr (chrtr_name, ".ch2"))
+        {
+          options->chrtr2 = NVTrue;
+        }
+      else
+        {
+          options->chrtr2 = NVFalse;
+        }
+
+
+      char name[512];
+
+      if (output_name[0])
+        {
+          strcpy (name, output_name);
+        }
+      else
+        {
+          snprintf (name, sizeof (name), "%s.tif", chrtr_name);
+        }
+
+
+      fprintf (stderr, "Input CHRTR file : %s\n", chrtr_name);
+
+      batchProgress prog;
+      chrtrRenderEngine engine (options, &prog);
+
+      if (engine.run (chrtr_name, name, area_name, contour) != RENDER_SUCCESS)
+        {
+          fprintf (stderr, "Error converting %s : %s\n", chrtr_name, engine.errorString ().toLatin1 ().constData ());
+          status = -1;
+        }
+    }
+
+
+  delete options;
+
+  return (status);
+}
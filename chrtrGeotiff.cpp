@@ -157,10 +157,25 @@ void chrtrGeotiff::initializePage (int id)
     case 2:
       options.transparent = field ("transparent_check").toBool ();
       options.caris = field ("caris_check").toBool ();
+      options.cog = field ("cog_check").toBool ();
+      options.codec_level = field ("codec_level").toInt ();
       options.grey = field ("grey_check").toBool ();
+      options.tiled = field ("tiled_check").toBool ();
+      options.tile_width = options.tile_height = (field ("tile_size").toInt () / 16) * 16;
+      options.overviews = field ("overviews_check").toBool ();
+      options.ov_color_resampling = field ("ov_color_resampling").toInt ();
+      options.ov_grey_resampling = field ("ov_grey_resampling").toInt ();
       options.dumb = field ("dumb_check").toBool ();
       options.elev = field ("elev_check").toBool ();
       options.cint = (float) field ("interval").toDouble ();
+      options.contour_format = field ("contour_format").toInt ();
+      options.num_threads = field ("threads").toInt ();
+      options.compress_threads = field ("compress_threads").toInt ();
+      options.stream = field ("stream_check").toBool ();
+      options.grid_cache = field ("grid_cache_check").toBool ();
+      options.stats_index = field ("stats_index_check").toBool ();
+
+      ip->setPreviewFile (field ("chrtr_file_edit").toString (), options.chrtr2);
 
       if (options.grey)
         {
@@ -173,6 +188,8 @@ void chrtrGeotiff::initializePage (int id)
       break;
 
     case 3:
+      ip->stopPreview ();
+
       button (QWizard::CustomButton1)->setEnabled (true);
 
       chrtr_file_name = field ("chrtr_file_edit").toString ();
@@ -242,17 +259,48 @@ void chrtrGeotiff::initializePage (int id)
           break;
         }
 
-      switch (options.caris)
+      if (options.cog)
         {
-        case false:
-          string = tr ("LZW compressed output format");
+          string = QString (tr ("Cloud Optimized GeoTIFF output format, %1 by %1 pixel %2 compressed tiles")).arg
+            (options.tile_width).arg (chrtrRenderEngine::codecName (options.codec));
           checkList->addItem (string);
-          break;
+        }
+      else
+        {
+          switch (options.caris)
+            {
+            case false:
+              string = QString (tr ("%1 compressed output format")).arg (chrtrRenderEngine::codecName (options.codec));
+              checkList->addItem (string);
+              break;
 
-        case true:
-          string = tr ("Brain-dead Caris output format");
+            case true:
+              string = tr ("Brain-dead Caris output format");
+              checkList->addItem (string);
+              break;
+            }
+
+          if (options.tiled && !options.caris)
+            {
+              string = QString (tr ("Tiled output, %1 by %2 pixel tiles")).arg (options.tile_width).arg (options.tile_height);
+              checkList->addItem (string);
+            }
+        }
+
+      if (options.overviews && (options.cog || !options.caris))
+        {
+          int32_t ov_resampling = options.ov_color_resampling;
+          if (options.grey) ov_resampling = options.ov_grey_resampling;
+
+          if (ov_resampling == OVERVIEW_AVERAGE)
+            {
+              string = tr ("Internal overviews will be built (average)");
+            }
+          else
+            {
+              string = tr ("Internal overviews will be built (nearest neighbor)");
+            }
           checkList->addItem (string);
-          break;
         }
 
       switch (options.elev)
@@ -272,7 +320,8 @@ void chrtrGeotiff::initializePage (int id)
       if (options.cint != 0.0)
         {
           contour = NVTrue;
-          string = QString (tr ("ESRI contour file will be generated with a contour interval of %1")).arg (options.cint, 6, 'f', 2);
+          string = QString (tr ("%1 contour file will be generated with a contour interval of %2")).arg (contourSink::formatName (options.contour_format))
+            .arg (options.cint, 6, 'f', 2);
           checkList->addItem (string);
         }
       else
@@ -281,6 +330,34 @@ void chrtrGeotiff::initializePage (int id)
         }
 
 
+      if (options.stream)
+        {
+          if (contour)
+            {
+              string = tr ("Low memory mode ignored since contours need the entire grid");
+            }
+          else
+            {
+              string = tr ("Low memory mode, the grid will be read twice");
+            }
+          checkList->addItem (string);
+        }
+
+
+      if (options.grid_cache)
+        {
+          string = tr ("Grid cache in %1").arg (options.cache_dir);
+          checkList->addItem (string);
+        }
+
+
+      if (options.stats_index)
+        {
+          string = tr ("Min/max from the statistics index");
+          checkList->addItem (string);
+        }
+
+
 
       switch (options.units)
         {
@@ -417,26 +494,13 @@ void chrtrGeotiff::slotHelpClicked ()
 
 
 
-//  This is where the fun stuff happens.
+//  This is where the fun stuff happens.  The actual conversion is done by chrtrRenderEngine (chrtrRenderEngine.cpp)
+//  so that we can share it with batch mode (batch.cpp).
 
 void 
 chrtrGeotiff::slotCustomButtonClicked (int id __attribute__ ((unused)))
 {
-  int32_t             chrtr_handle, width, height, x_start, y_start, count = 0, header_width, header_height, c_index;
-  float               *ar, *current_row, *next_row, min_z, max_z, range[2] = {0.0, 0.0}, shade_factor, null_value = 0.0;
-  double              conversion_factor, mid_y_radians, x_cell_size, y_cell_size, x_cell_degrees, y_cell_degrees;
-  double              polygon_x[200], polygon_y[200];
-  NV_F64_XYMBR        mbr;
-  NV_F64_MBR          header_mbr;
-  uint8_t             cross_zero = NVFalse;
-  CHRTR_HEADER        chrtr_header;
-  CHRTR2_HEADER       chrtr2_header;
-  CHRTR2_RECORD       *chrtr2_record = NULL;
-  char                basename[512], name[512], chrtr_name[512], area_file[512];
-  QString             string;
-
-
-  int32_t scribe (int32_t, int32_t, float, float, float, float, float *, char *, OPTIONS *, double, double);
+  char                chrtr_name[512], name[512], area_file[512];
 
 
   QApplication::setOverrideCursor (Qt::WaitCursor);
@@ -447,541 +511,42 @@ chrtrGeotiff::slotCustomButtonClicked (int id __attribute__ ((unused)))
   button (QWizard::CustomButton1)->setEnabled (false);
 
 
-  //  Note - The sunopts and the color_array get set in display_sample_data (imagePage.cpp).  No point in
-  //  doing it twice.
-
   strcpy (chrtr_name, chrtr_file_name.toLatin1 ());
+  strcpy (name, output_file_name.toLatin1 ());
+  strcpy (area_file, area_file_name.toLatin1 ());
 
 
-  x_start = 0;
-  y_start = 0;
-
-
-  if (options.chrtr2)
-    {
-      if ((chrtr_handle = chrtr2_open_file (chrtr_name, &chrtr2_header, CHRTR2_READONLY)) < 0)
-        {
-          chrtr2_perror ();
-          exit (-1);
-        }
-
-
-      header_width = width = chrtr2_header.width;
-      header_height = height = chrtr2_header.height;
-
-
-      header_mbr.wlon = mbr.min_x = chrtr2_header.mbr.wlon;
-      header_mbr.elon = mbr.max_x = chrtr2_header.mbr.elon;
-      header_mbr.slat = mbr.min_y = chrtr2_header.mbr.slat;
-      header_mbr.nlat = mbr.max_y = chrtr2_header.mbr.nlat;
-
-      y_cell_degrees = chrtr2_header.lat_grid_size_degrees;
-      x_cell_degrees = chrtr2_header.lon_grid_size_degrees;
-
-      min_z = CHRTR2_NULL_Z_VALUE;
-      max_z = -CHRTR2_NULL_Z_VALUE;
-      null_value = CHRTR2_NULL_Z_VALUE;
-    }
-  else
-    {
-      if ((chrtr_handle = open_chrtr (chrtr_name, &chrtr_header)) < 0)
-        {
-          perror (chrtr_name);
-          exit (-1);
-        }
-
-
-      header_width = width = chrtr_header.width;
-      header_height = height = chrtr_header.height;
-
-
-      header_mbr.wlon = mbr.min_x = chrtr_header.wlon;
-      header_mbr.elon = mbr.max_x = chrtr_header.elon;
-      header_mbr.slat = mbr.min_y = chrtr_header.slat;
-      header_mbr.nlat = mbr.max_y = chrtr_header.nlat;
-
-      y_cell_degrees = x_cell_degrees = chrtr_header.grid_minutes / 60.0;
-
-      min_z = CHRTRNULL;
-      max_z = -CHRTRNULL;
-      null_value = CHRTRNULL;
-    }
-
-
-  strcpy (basename, output_file_name.toLatin1 ());
-
-  if (strcmp (&basename[strlen (basename) - 4], ".tif")) strcat (basename, ".tif");
-
-  strcpy (name, basename);
-
-
-  //  Check for an area file.
-
-  if (!area_file_name.isEmpty ())
-    {
-      strcpy (area_file, area_file_name.toLatin1 ());
-
-      if (!get_area_mbr (area_file, &count, polygon_x, polygon_y, &mbr))
-        {
-          QString qstring = QString (tr ("Error reading area file %1\nReason : %2")).arg (area_file_name).arg (QString (strerror (errno)));
-          QMessageBox::critical (this, tr ("chrtrGeotiff"), qstring);
-          exit (-1);
-        }
-
-
-      if (mbr.min_y > header_mbr.nlat || mbr.max_y < header_mbr.slat || mbr.min_x > header_mbr.elon || mbr.max_x < header_mbr.wlon)
-        {
-          QString qstring = QString (tr ("Specified area is completely outside of the CHRTR bounds!"));
-          QMessageBox::critical (this, tr ("chrtrGeotiff"), qstring);
-          exit (-1);
-        }
-
-
-      //  Match to nearest cell
-
-      x_start = NINT ((mbr.min_x - header_mbr.wlon) / x_cell_degrees);
-      y_start = NINT ((mbr.min_y - header_mbr.slat) / y_cell_degrees);
-      width = NINT ((mbr.max_x - mbr.min_x) / x_cell_degrees);
-      height = NINT ((mbr.max_y - mbr.min_y) / y_cell_degrees);
-
-
-      //  Adjust to CHRTR bounds if necessary
-
-      if (x_start < 0) x_start = 0;
-      if (y_start < 0) y_start = 0;
-      if (x_start + width > header_width) width = header_width - x_start;
-      if (y_start + height > header_height) height = header_height - y_start;
-
-
-      //  Redefine bounds
-
-      mbr.min_x = header_mbr.wlon + x_start * x_cell_degrees;
-      mbr.min_y = header_mbr.slat + y_start * y_cell_degrees;
-      mbr.max_x = mbr.min_x + width * x_cell_degrees;
-      mbr.max_y = mbr.min_y + height * y_cell_degrees;
-    }
-
-
-  progress.mbar->setRange (0, height);
-
-
-  //  Compute cell sizes for sunshading.
-
-  mid_y_radians = (header_mbr.nlat - header_mbr.slat) * 0.0174532925199432957692;
-  conversion_factor = cos (mid_y_radians);
-  x_cell_size = x_cell_degrees * 111120.0 * conversion_factor;
-  y_cell_size = y_cell_degrees * 111120.0;
-
-
-  uint8_t *red = NULL, *blue = NULL, *green = NULL, *alpha = NULL;
-
-  if ((red = (uint8_t *) calloc (width, sizeof (uint8_t))) == NULL)
-    {
-      perror ("Allocating red in chrtrGeotiff.cpp");
-      exit (-1);
-    }
-  if ((green = (uint8_t *) calloc (width, sizeof (uint8_t))) == NULL)
-    {
-      perror ("Allocating green in chrtrGeotiff.cpp");
-      exit (-1);
-    }
-  if ((blue = (uint8_t *) calloc (width, sizeof (uint8_t))) == NULL)
-    {
-      perror ("Allocating blue in chrtrGeotiff.cpp");
-      exit (-1);
-    }
-  if ((alpha = (uint8_t *) calloc (width, sizeof (uint8_t))) == NULL)
-    {
-      perror ("Allocating alpha in chrtrGeotiff.cpp");
-      exit (-1);
-    }
-  if ((next_row = (float *) calloc (width, sizeof (float))) == NULL)
-    {
-      perror ("Allocating next_row in chrtrGeotiff.cpp");
-      exit (-1);
-    }
-  if ((current_row = (float *) calloc (width, sizeof (float))) == NULL)
-    {
-      perror ("Allocating current_row in chrtrGeotiff.cpp");
-      exit (-1);
-    }
-
-
-  if (options.chrtr2)
-    {
-      if ((chrtr2_record = (CHRTR2_RECORD *) calloc (width, sizeof (CHRTR2_RECORD))) == NULL)
-        {
-          perror ("Allocating chrtr2_record in chrtrGeotiff.cpp");
-          exit (-1);
-        }
-    }
-
-
-  int32_t ar_size = width * height;
-
-  ar = (float *) calloc (ar_size, sizeof (float));
-  if (ar == NULL)
-    {
-      perror ("Allocating ar in chrtrGeotiff.cpp");
-      exit (-1);
-    }
-
-
-  //  Scan for min/max and load the grid array.
-
-  for (int32_t i = 0, m = 1 ; i < height ; i++, m++)
-    {
-      if (options.chrtr2)
-        {
-          chrtr2_read_row (chrtr_handle, y_start + i, x_start, width, chrtr2_record);
-
-          for (int32_t j = 0 ; j < width ; j++)
-            {
-              float z_value = chrtr2_record[j].z;
-
-              if (chrtr2_record[j].status)
-                {
-                  if (options.units)
-                    {
-                      if (options.dumb)
-                        {
-                          z_value /= 1.875;
-                        }
-                      else
-                        {
-                          z_value /= 1.8288;
-                        }
-                    }
-
-
-                  if (options.elev) z_value = -z_value;
-
-
-                  //  Load the 1D array.
-
-                  ar[i * width + j] = z_value; 
-
-
-                  //  Compute the min/max
-
-                  min_z = qMin (min_z, z_value);
-                  max_z = qMax (max_z, z_value);
-                }
-              else
-                {
-                  //  Load the 1D array.
-
-                  ar[i * width + j] = null_value;
-                }
-            }
-        }
-      else
-        {
-          read_chrtr (chrtr_handle, y_start + i, x_start, width, current_row);
-
-
-          for (int32_t j = 0 ; j < width ; j++)
-            {
-              if (current_row[j] < null_value)
-                {
-                  float z_value = current_row[j];
-
-                  if (options.units)
-                    {
-                      if (options.dumb)
-                        {
-                          z_value /= 1.875;
-                        }
-                      else
-                        {
-                          z_value /= 1.8288;
-                        }
-                    }
-
-
-                  if (options.elev) z_value = -z_value;
-
-
-                  //  Load the 1D array.
-
-                  ar[i * width + j] = z_value; 
-
-
-                  //  Compute the min/max
-
-                  min_z = qMin (min_z, z_value);
-                  max_z = qMax (max_z, z_value);
-                }
-              else
-                {
-                  //  Load the 1D array.
-
-                  ar[i * width + j] = null_value; 
-                }
-            }
-        }
-
-
-      progress.mbar->setValue (m);
-
-      qApp->processEvents ();
-    }
-
-
-  progress.mbar->setValue (height);
-
-
-  if (options.chrtr2) free (chrtr2_record);
-
-
-  progress.gbar->setRange (0, height);
-
-
-  if (options.restart && min_z < 0.0)
-    {
-      range[0] = -min_z;
-      range[1] = max_z;
-
-      cross_zero = NVTrue;
-    }
-  else
-    {
-      range[0] = max_z - min_z;
-
-      cross_zero = NVFalse;
-    }
-
-
-  GDALDataset         *df;
-  char                *wkt = NULL;
-  GDALRasterBand      *bd[4];
-  double              trans[6];
-  GDALDriver          *gt;
-  char                **papszOptions = NULL;
-
-
-  //  Set up the output GeoTIFF file.
-
-  GDALAllRegister ();
-
-  gt = GetGDALDriverManager ()->GetDriverByName ("GTiff");
-  if (!gt)
-    {
-      fprintf (stderr, "Could not get GTiff driver\n");
-      exit (-1);
-    }
-
-  int32_t bands = 3;
-  if (options.transparent) bands = 4;
-
-
-  //  Stupid Caris software can't read normal files!
-
-  if (options.caris)
-    {
-      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "PACKBITS");
-    }
-  else
-    {
-      papszOptions = CSLSetNameValue (papszOptions, "TILED", "NO");
-      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "LZW");
-    }
-
-  if (options.grey)
-    {
-      bands = 1;
-      df = gt->Create (name, width, height, bands, GDT_Float32, papszOptions);
-    }
-  else
-    {
-      df = gt->Create (name, width, height, bands, GDT_Byte, papszOptions);
-    }
-
-  if (df == NULL)
-    {
-      fprintf (stderr, "Could not create %s\n", name);
-      exit (-1);
-    }
-
-  trans[0] = mbr.min_x;
-  trans[1] = x_cell_degrees;
-  trans[2] = 0.0;
-  trans[3] = mbr.max_y;
-  trans[4] = 0.0;
-  trans[5] = -y_cell_degrees;
-  df->SetGeoTransform (trans);
-
-  char wkt_str[1024];
-  strcpy (wkt_str, "COMPD_CS[\"WGS84 with WGS84E Z\",GEOGCS[\"WGS 84\",DATUM[\"WGS_1984\",SPHEROID[\"WGS 84\",6378137,298.257223563,AUTHORITY[\"EPSG\",\"7030\"]],TOWGS84[0,0,0,0,0,0,0],AUTHORITY[\"EPSG\",\"6326\"]],PRIMEM[\"Greenwich\",0,AUTHORITY[\"EPSG\",\"8901\"]],UNIT[\"degree\",0.01745329251994328,AUTHORITY[\"EPSG\",\"9108\"]],AXIS[\"Lat\",NORTH],AXIS[\"Long\",EAST],AUTHORITY[\"EPSG\",\"4326\"]],VERT_CS[\"ellipsoid Z in meters\",VERT_DATUM[\"Ellipsoid\",2002],UNIT[\"metre\",1],AXIS[\"Z\",UP]]]");
-  wkt = wkt_str;
-
-  df->SetProjection (wkt);
-
-
-  for (int32_t i = 0 ; i < bands ; i++) bd[i] = df->GetRasterBand (i + 1);
-
-
-  if (options.grey) bd[0]->SetNoDataValue (null_value);
-
-
-  for (int32_t i = height - 1, k = 0 ; i >= 0 ; i--, k++)
-    {
-      CPLErr err;
-
-      if (options.grey)
-        {
-          for (int32_t j = 0 ; j < width ; j++) current_row[j] = ar[(y_start + i) * width + j];
-        }
-      else
-        {
-          if (i == (height - 1))
-            {
-              for (int32_t j = 0 ; j < width ; j++) current_row[j] = ar[(y_start + i) * width + j];
-              memcpy (next_row, current_row, width * sizeof (float));
-            }
-          else
-            {
-              memcpy (current_row, next_row, width * sizeof (float));
-              for (int32_t j = 0 ; j < width ; j++) next_row[j] = ar[(y_start + i) * width + j];
-            }
-        }
-
-
-      if (options.grey)
-        {
-          err = bd[0]->RasterIO (GF_Write, 0, k, width, 1, current_row, width, 1, GDT_Float32, 0, 0);
-        }
-      else
-        {
-          for (int32_t j = 0 ; j < width ; j++)
-            {
-              if (cross_zero)
-                {
-                  if (current_row[j] < 0.0)
-                    {
-                      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((current_row[j] - min_z) / range[0] * NUMHUES))) * NUMSHADES;
-                    }
-                  else
-                    {
-                      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf (current_row[j]) / range[1] * NUMHUES)) * NUMSHADES;
-                    }
-                }
-              else
-                {
-                  c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((current_row[j] - min_z) / range[0] * NUMHUES))) * NUMSHADES;
-                }
-
-              if (current_row[j] >= null_value) c_index = -2; 
-
-              shade_factor = sunshade (next_row, current_row, j, &options.sunopts, x_cell_size, y_cell_size);
-
-              if (shade_factor < 0.0) shade_factor = options.sunopts.min_shade;
-
-              c_index -= NINT (NUMSHADES * shade_factor + 0.5);
-
-
-              if (c_index >= 0)
-                {
-                  red[j] = options.color_array[c_index].red ();
-                  green[j] = options.color_array[c_index].green ();
-                  blue[j] = options.color_array[c_index].blue ();
-                  alpha[j] = 255;
-                }
-              else
-                {
-                  red[j] = green[j] = blue[j] = alpha[j] = 0;
-                }
-            }
+  checkList->clear ();
 
-          err = bd[0]->RasterIO (GF_Write, 0, k, width, 1, red, width, 1, GDT_Byte, 0, 0);
-          err = bd[1]->RasterIO (GF_Write, 0, k, width, 1, green, width, 1, GDT_Byte, 0, 0);
-          err = bd[2]->RasterIO (GF_Write, 0, k, width, 1, blue, width, 1, GDT_Byte, 0, 0);
-          if (options.transparent) err = bd[3]->RasterIO (GF_Write, 0, k, width, 1, alpha, width, 1, GDT_Byte, 0, 0);
-        }
 
-      if (err == CE_Failure)
-        {
-          checkList->clear ();
-
-          string = QString (tr ("Failed a TIFF scanline write - row %1")).arg (i);
-          checkList->addItem (string);
-        }
+  runProgress prog (&progress, checkList);
+  chrtrRenderEngine engine (&options, &prog);
 
+  int32_t status = engine.run (chrtr_name, name, area_file, contour);
 
-      progress.gbar->setValue (k + 1);
 
-      qApp->processEvents ();
-    }
+  button (QWizard::FinishButton)->setEnabled (true);
+  button (QWizard::CancelButton)->setEnabled (false);
 
 
-  checkList->clear ();
+  QApplication::restoreOverrideCursor ();
 
 
-  string = QString (tr ("Created TIFF file %1")).arg (name);
-  checkList->addItem (string);
+  if (status != RENDER_SUCCESS) QMessageBox::critical (this, tr ("chrtrGeotiff"), engine.errorString ());
 
-  string = QString (tr ("%1 rows by %2 columns")).arg (height).arg (width);
-  checkList->addItem (string);
 
+  checkList->addItem (" ");
 
-  if (options.chrtr2)
+  QListWidgetItem *cur;
+  if (status == RENDER_SUCCESS)
     {
-      chrtr2_close_file (chrtr_handle);
+      cur = new QListWidgetItem (tr ("Conversion complete, press Finish to exit."));
     }
   else
     {
-      close_chrtr (chrtr_handle);
+      cur = new QListWidgetItem (tr ("Conversion failed : ") + engine.errorString ());
     }
 
-
-  free (red);
-  free (green);
-  free (blue);
-  free (alpha);
-  free (next_row);
-  free (current_row);
-
-
-  delete df;
-
-
-  //  Contouring if requested.
-
-  progress.cbar->setRange (0, 0);
-
-  if (contour)
-    {
-      int32_t num_contours = scribe (width, height, mbr.min_x, mbr.min_y, min_z, max_z, ar, name, &options, x_cell_degrees, y_cell_degrees);
-
-
-      string.sprintf (tr ("Generated %d contour segments").toLatin1 (), num_contours);
-      QListWidgetItem *cur = new QListWidgetItem (string);
-
-
-      checkList->addItem (cur);
-      checkList->setCurrentItem (cur);
-      checkList->scrollToItem (cur);
-    }
-
-
-  free (ar);
-
-
-  progress.cbar->setRange (0, 100);
-  progress.cbar->setValue (100);
-  qApp->processEvents ();
-
-
-  button (QWizard::FinishButton)->setEnabled (true);
-  button (QWizard::CancelButton)->setEnabled (false);
-
-
-  QApplication::restoreOverrideCursor ();
-
-
-  checkList->addItem (" ");
-  QListWidgetItem *cur = new QListWidgetItem (tr ("Conversion complete, press Finish to exit."));
-
   checkList->addItem (cur);
   checkList->setCurrentItem (cur);
   checkList->scrollToItem (cur);
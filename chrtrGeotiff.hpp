@@ -40,6 +40,7 @@
 #define CHRTRGEOTIFF_H
 
 #include "chrtrGeotiffDef.hpp"
+#include "contourSink.hpp"
 #include "startPage.hpp"
 #include "surfacePage.hpp"
 #include "imagePage.hpp"
@@ -7,6 +7,7 @@ LIBS += -L /c/PFM_ABEv7.0.0_Win64/lib -lchrtr2 -lnvutility -lgdal -lxml2 -lpoppl
 DEFINES += WIN32 NVWIN3X
 CONFIG += console
 QMAKE_LFLAGS += 
+QMAKE_CXXFLAGS += -ffp-contract=off
 ######################################################################
 # Automatically generated by qmake (2.01a) Wed Jan 22 14:00:42 2020
 ######################################################################
@@ -17,26 +18,49 @@ DEPENDPATH += .
 INCLUDEPATH += .
 
 # Input
-HEADERS += chrtrGeotiff.hpp \
+HEADERS += areaMask.hpp \
+           chrtrGeotiff.hpp \
            chrtrGeotiffDef.hpp \
            chrtrGeotiffHelp.hpp \
+           chrtrReader.hpp \
+           chrtrRenderEngine.hpp \
+           contourEngine.hpp \
+           contourSink.hpp \
+           gridCache.hpp \
            imagePage.hpp \
            imagePageHelp.hpp \
+           previewThread.hpp \
+           renderDataset.hpp \
            runPage.hpp \
+           shapeWriter.hpp \
            startPage.hpp \
+           statsIndex.hpp \
            startPageHelp.hpp \
            surfacePage.hpp \
            surfacePageHelp.hpp \
            version.hpp
-SOURCES += chrtrGeotiff.cpp \
+SOURCES += areaMask.cpp \
+           batch.cpp \
+           chrtrGeotiff.cpp \
+           chrtrReader.cpp \
+           chrtrRenderEngine.cpp \
+           color_index_row.cpp \
+           contourEngine.cpp \
+           contourSink.cpp \
            env_in_out.cpp \
+           gridCache.cpp \
            hsvrgb.cpp \
            imagePage.cpp \
            main.cpp \
            palshd.cpp \
+           previewThread.cpp \
+           renderDataset.cpp \
            runPage.cpp \
            scribe.cpp \
            set_defaults.cpp \
+           shapeWriter.cpp \
            startPage.cpp \
+           statsIndex.cpp \
+           sunshade_row.cpp \
            surfacePage.cpp
 RESOURCES += icons.qrc
@@ -68,6 +68,27 @@
 #define         SAMPLE_WIDTH        130
 
 
+//  Compression codecs (options.codec).  Caris format always uses PACKBITS.
+
+#define         CODEC_LZW           0
+#define         CODEC_DEFLATE       1
+#define         CODEC_ZSTD          2
+#define         CODEC_LZMA          3
+
+
+//  Overview resampling (options.ov_color_resampling and options.ov_grey_resampling).
+
+#define         OVERVIEW_NEAREST    0
+#define         OVERVIEW_AVERAGE    1
+
+
+//  Contour file formats (options.contour_format).
+
+#define         CONTOUR_SHAPEFILE   0
+#define         CONTOUR_GPKG        1
+#define         CONTOUR_FGB         2
+
+
 typedef struct
 {
   uint8_t       chrtr2;
@@ -77,7 +98,16 @@ typedef struct
   int32_t       window_height;
   uint8_t       transparent;
   uint8_t       caris;
+  uint8_t       cog;                        //  Write a Cloud Optimized GeoTIFF (overrides caris and tiled)
+  int32_t       codec;                      //  CODEC_LZW, CODEC_DEFLATE, CODEC_ZSTD, or CODEC_LZMA
+  int32_t       codec_level;                //  Compression level (0 for the codec's default, not used for LZW)
   uint8_t       grey;
+  uint8_t       tiled;                      //  Write a tiled GeoTIFF (ignored for Caris format)
+  int32_t       tile_width;                 //  BLOCKXSIZE for tiled output (multiple of 16)
+  int32_t       tile_height;                //  BLOCKYSIZE for tiled output (multiple of 16)
+  uint8_t       overviews;                  //  Build internal overviews while rendering (ignored for Caris format)
+  int32_t       ov_color_resampling;        //  OVERVIEW_NEAREST or OVERVIEW_AVERAGE for color overviews
+  int32_t       ov_grey_resampling;         //  OVERVIEW_NEAREST or OVERVIEW_AVERAGE for 32 bit grey scale overviews
   uint8_t       restart;
   double        azimuth;
   double        elevation;
@@ -91,8 +121,15 @@ typedef struct
   uint8_t       dumb;
   uint8_t       elev;
   float         cint;
+  int32_t       contour_format;             //  CONTOUR_SHAPEFILE, CONTOUR_GPKG, or CONTOUR_FGB
   int32_t       smoothing_factor;
   int32_t       maxd;
+  int32_t       num_threads;                //  Number of render threads, 0 means use all of the cores
+  int32_t       compress_threads;           //  Number of GDAL compression threads, 0 means use all of the cores
+  uint8_t       stream;                     //  Don't hold the whole grid in memory (ignored when contouring)
+  uint8_t       grid_cache;                 //  Save the loaded grid in, and map it from, the grid cache (see gridCache)
+  QString       cache_dir;                  //  Grid cache directory
+  uint8_t       stats_index;                //  Get the min/max from (and build) the .stats index file (see statsIndex)
   QColor        color_array[NUMSHADES * (NUMHUES + 1)];
   int16_t       sample_data[SAMPLE_HEIGHT][SAMPLE_WIDTH];
   float         sample_min, sample_max;
@@ -118,6 +155,10 @@ typedef struct
 
 
 float sunshade(float *lower_row, float *upper_row, int32_t col_num, SUN_OPT *sunopts, double x_cell_size, double y_cell_size);
+void sunshade_row (float *lower_row, float *upper_row, int32_t width, SUN_OPT *sunopts, double x_cell_size,
+                   double y_cell_size, float null_value, float *shade);
+void color_index_row (float *row, float *shade, int32_t width, float min_z, float *range, uint8_t cross_zero,
+                      float null_value, int32_t *c_index);
 
 
 #endif
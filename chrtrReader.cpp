@@ -0,0 +1,292 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "chrtrReader.hpp"
+
+#ifndef NVWIN3X
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+chrtrReader::chrtrReader ()
+{
+  chrtr2 = NVFalse;
+  handle = -1;
+  width = height = 0;
+  record = NULL;
+  x_cell_degrees = y_cell_degrees = 0.0;
+  null_value = 0.0;
+  fd = -1;
+  file_size = 0;
+  row_bytes = 0.0;
+  last_row = ahead_start = ahead_end = -1;
+}
+
+
+
+chrtrReader::~chrtrReader ()
+{
+  close ();
+}
+
+
+
+//!  Open a CHRTR (chrtr2_flag = NVFalse) or CHRTR2 file.  Returns 0 on success, -1 on error (see errorString).
+
+int32_t chrtrReader::open (char *name, uint8_t chrtr2_flag)
+{
+  close ();
+
+  chrtr2 = chrtr2_flag;
+
+
+  if (chrtr2)
+    {
+      if ((handle = chrtr2_open_file (name, &chrtr2_header, CHRTR2_READONLY)) < 0)
+        {
+          error_string = QString (chrtr2_strerror ());
+          return (-1);
+        }
+
+      width = chrtr2_header.width;
+      height = chrtr2_header.height;
+
+      mbr.wlon = chrtr2_header.mbr.wlon;
+      mbr.elon = chrtr2_header.mbr.elon;
+      mbr.slat = chrtr2_header.mbr.slat;
+      mbr.nlat = chrtr2_header.mbr.nlat;
+
+      y_cell_degrees = chrtr2_header.lat_grid_size_degrees;
+      x_cell_degrees = chrtr2_header.lon_grid_size_degrees;
+
+      null_value = CHRTR2_NULL_Z_VALUE;
+
+
+      if ((record = (CHRTR2_RECORD *) calloc (width, sizeof (CHRTR2_RECORD))) == NULL)
+        {
+          error_string = QObject::tr ("Unable to allocate CHRTR2 row buffer : ") + QString (strerror (errno));
+          close ();
+          return (-1);
+        }
+    }
+  else
+    {
+      if ((handle = open_chrtr (name, &chrtr_header)) < 0)
+        {
+          error_string = QString (name) + " : " + QString (strerror (errno));
+          return (-1);
+        }
+
+      width = chrtr_header.width;
+      height = chrtr_header.height;
+
+      mbr.wlon = chrtr_header.wlon;
+      mbr.elon = chrtr_header.elon;
+      mbr.slat = chrtr_header.slat;
+      mbr.nlat = chrtr_header.nlat;
+
+      y_cell_degrees = x_cell_degrees = chrtr_header.grid_minutes / 60.0;
+
+      null_value = CHRTRNULL;
+    }
+
+
+  adviseFile (name);
+
+
+  return (0);
+}
+
+
+
+/*!
+  Open a second descriptor on the file that's only used to give the kernel read ahead hints (posix_fadvise).  If
+  this fails for any reason we just read without the hints.  We don't know the size of the header so we use file
+  size / rows for the row size.  That's off by at most one header for the last row which readAhead covers by
+  padding the range.
+*/
+
+void chrtrReader::adviseFile (char *name)
+{
+#ifndef NVWIN3X
+  if ((fd = ::open (name, O_RDONLY)) < 0) return;
+
+  struct stat st;
+  if (fstat (fd, &st) || !st.st_size || !height)
+    {
+      ::close (fd);
+      fd = -1;
+      return;
+    }
+
+  file_size = st.st_size;
+  row_bytes = (double) file_size / (double) height;
+#endif
+}
+
+
+
+//!  Ask the kernel to start reading the next READ_AHEAD_ROWS rows in the direction we're moving.
+
+void chrtrReader::readAhead (int32_t row)
+{
+#ifndef NVWIN3X
+  if (fd < 0) return;
+
+
+  //  Still inside the last range we asked for, nothing to do.
+
+  if (row >= ahead_start && row <= ahead_end)
+    {
+      last_row = row;
+      return;
+    }
+
+
+  if (last_row >= 0 && row < last_row)
+    {
+      ahead_start = qMax (0, row - READ_AHEAD_ROWS);
+      ahead_end = row;
+    }
+  else
+    {
+      ahead_start = row;
+      ahead_end = qMin (height - 1, row + READ_AHEAD_ROWS);
+    }
+
+  last_row = row;
+
+
+  int64_t page = sysconf (_SC_PAGESIZE);
+  int64_t pad = (int64_t) row_bytes + page;
+  int64_t start = qMax ((int64_t) 0, (int64_t) (ahead_start * row_bytes) - pad);
+  int64_t end = qMin (file_size, (int64_t) ((ahead_end + 1) * row_bytes) + pad);
+
+  start = (start / page) * page;
+
+
+  //  WILLNEED starts reading the range into the page cache whichever descriptor it's given so the library's reads
+  //  find it there.  SEQUENTIAL would only change the read ahead of our descriptor (and only going forward) so we
+  //  ask for the range ourselves instead.
+
+  if (end > start) posix_fadvise (fd, start, end - start, POSIX_FADV_WILLNEED);
+#endif
+}
+
+
+
+/*!
+  Read count Z values from row, col into dest.  Empty cells are set to nullValue ().  No unit conversion is done
+  here.  A reader has one file handle and one row buffer so only one thread at a time may call this.  Threads that
+  need to read at the same time should each open their own chrtrReader on the file.
+*/
+
+void chrtrReader::readRow (int32_t row, int32_t col, int32_t count, float *dest)
+{
+  readAhead (row);
+
+
+  if (chrtr2)
+    {
+      chrtr2_read_row (handle, row, col, count, record);
+
+      for (int32_t j = 0 ; j < count ; j++)
+        {
+          if (record[j].status)
+            {
+              dest[j] = record[j].z;
+            }
+          else
+            {
+              dest[j] = null_value;
+            }
+        }
+    }
+  else
+    {
+      read_chrtr (handle, row, col, count, dest);
+
+      for (int32_t j = 0 ; j < count ; j++)
+        {
+          if (dest[j] >= null_value) dest[j] = null_value;
+        }
+    }
+}
+
+
+
+//!  Close the file and the read ahead descriptor.  Safe to call more than once.
+
+void chrtrReader::close ()
+{
+#ifndef NVWIN3X
+  if (fd >= 0)
+    {
+      ::close (fd);
+      fd = -1;
+      file_size = 0;
+    }
+#endif
+
+
+  if (handle >= 0)
+    {
+      if (chrtr2)
+        {
+          chrtr2_close_file (handle);
+        }
+      else
+        {
+          close_chrtr (handle);
+        }
+
+      handle = -1;
+    }
+
+
+  if (record)
+    {
+      free (record);
+      record = NULL;
+    }
+
+
+  last_row = ahead_start = ahead_end = -1;
+}
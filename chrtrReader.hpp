@@ -0,0 +1,118 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef CHRTRREADER_H
+#define CHRTRREADER_H
+
+#include "chrtrGeotiffDef.hpp"
+
+
+//  Number of rows we ask the kernel to read ahead of the row being read.
+
+#define         READ_AHEAD_ROWS                 256
+
+
+/*!
+  CHRTR/CHRTR2 row reader.  This hides the difference between the two file types and returns rows of Z values
+  with empty cells set to nullValue ().  The rows are still decoded by chrtr2_read_row/read_chrtr (the CHRTR2
+  record packing belongs to the CHRTR2 library) through one file handle so a reader isn't thread safe.  Threads
+  that have to read at the same time each open their own reader.
+
+  On Linux, as rows are read, the next READ_AHEAD_ROWS rows (in whichever direction we're going) are handed to
+  posix_fadvise (POSIX_FADV_WILLNEED) on a second, read only, descriptor.  The kernel then pulls them into the page
+  cache in the background so the library's reads don't have to wait on the disk.
+
+  This is only a hint, the file isn't memory mapped.  Rows can't be decoded from a mapping without the CHRTR2
+  record layout and, with a cold cache, copying rows out of a mapping was slower than reading them (much slower
+  going north to south).
+*/
+
+class chrtrReader
+{
+public:
+
+  chrtrReader ();
+  ~chrtrReader ();
+
+  int32_t open (char *name, uint8_t chrtr2_flag);
+  void close ();
+  void readRow (int32_t row, int32_t col, int32_t count, float *dest);
+
+  QString errorString () {return (error_string);};
+  int32_t cols () {return (width);};
+  int32_t rows () {return (height);};
+  NV_F64_MBR bounds () {return (mbr);};
+  double xCellDegrees () {return (x_cell_degrees);};
+  double yCellDegrees () {return (y_cell_degrees);};
+  float nullValue () {return (null_value);};
+
+
+protected:
+
+  void adviseFile (char *name);
+  void readAhead (int32_t row);
+
+
+  QString          error_string;
+
+  uint8_t          chrtr2;
+
+  int32_t          handle, width, height;
+
+  CHRTR_HEADER     chrtr_header;
+
+  CHRTR2_HEADER    chrtr2_header;
+
+  CHRTR2_RECORD    *record;
+
+  NV_F64_MBR       mbr;
+
+  double           x_cell_degrees, y_cell_degrees;
+
+  float            null_value;
+
+  int32_t          fd;
+
+  int64_t          file_size;
+
+  double           row_bytes;
+
+  int32_t          last_row, ahead_start, ahead_end;
+};
+
+#endif
@@ -0,0 +1,1985 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "chrtrRenderEngine.hpp"
+#include "renderDataset.hpp"
+
+
+//  Horizontal and vertical datum of the output GeoTIFF.
+
+static const char *wkt_string = "COMPD_CS[\"WGS84 with WGS84E Z\",GEOGCS[\"WGS 84\",DATUM[\"WGS_1984\",SPHEROID[\"WGS 84\",6378137,298.257223563,AUTHORITY[\"EPSG\",\"7030\"]],TOWGS84[0,0,0,0,0,0,0],AUTHORITY[\"EPSG\",\"6326\"]],PRIMEM[\"Greenwich\",0,AUTHORITY[\"EPSG\",\"8901\"]],UNIT[\"degree\",0.01745329251994328,AUTHORITY[\"EPSG\",\"9108\"]],AXIS[\"Lat\",NORTH],AXIS[\"Long\",EAST],AUTHORITY[\"EPSG\",\"4326\"]],VERT_CS[\"ellipsoid Z in meters\",VERT_DATUM[\"Ellipsoid\",2002],UNIT[\"metre\",1],AXIS[\"Z\",UP]]]";
+
+
+chrtrRenderEngine::chrtrRenderEngine (OPTIONS *op, renderProgress *prog)
+{
+  options = op;
+  progress = prog;
+
+  width = height = x_start = y_start = 0;
+  x_cell_degrees = y_cell_degrees = x_cell_size = y_cell_size = 0.0;
+  ar = NULL;
+  streaming = contour_requested = NVFalse;
+  min_z = max_z = null_value = 0.0;
+  range[0] = range[1] = 0.0;
+  cross_zero = NVFalse;
+  df = NULL;
+  bands = 0;
+  num_overviews = 0;
+  name[0] = 0;
+  rows_buf = shade_buf = NULL;
+  pixels = NULL;
+  index_buf = NULL;
+  thread = NULL;
+  num_threads = band_rows = chunk_rows = 0;
+}
+
+
+
+chrtrRenderEngine::~chrtrRenderEngine ()
+{
+  close ();
+}
+
+
+
+int32_t chrtrRenderEngine::setError (int32_t err, QString string)
+{
+  error_string = string;
+
+  return (err);
+}
+
+
+
+void chrtrRenderEngine::stageStart (int32_t stage, int32_t steps)
+{
+  if (progress) progress->stageStart (stage, steps);
+}
+
+
+
+void chrtrRenderEngine::stageProgress (int32_t stage, int32_t step)
+{
+  if (progress) progress->stageProgress (stage, step);
+}
+
+
+
+void chrtrRenderEngine::message (QString string)
+{
+  if (progress) progress->message (string);
+}
+
+
+
+/*!
+  Set the sun shading options and the color array from the image options.  Note that the start and end hues
+  are swapped in the call to palshd.  That's the way imagePage::display_sample_data has always done it.
+*/
+
+void chrtrRenderEngine::setColors ()
+{
+  void palshd (int num_shades, int num_hues, float start_hue, float end_hue, 
+               float min_saturation, float max_saturation, float min_value, 
+               float max_value, int start_color, QColor color_array[]);
+
+
+  options->sunopts.azimuth = options->azimuth;
+  options->sunopts.elevation = options->elevation;
+  options->sunopts.exag = options->exaggeration;
+  options->sunopts.power_cos = 1.0;
+  options->sunopts.num_shades = 50;
+  options->sunopts.min_shade = 0.0;
+  options->sunopts.sun = sun_unv (options->sunopts.azimuth, options->sunopts.elevation);
+
+
+  palshd (NUMSHADES, NUMHUES, (float) options->end_hsv, (float) options->start_hsv, (float) options->saturation,
+          (float) options->saturation, (float) options->value, 1.0, 0, options->color_array);
+
+
+  /*  Pack the colors into a table of 32 bit words once per run so the render loop doesn't have to call the
+      QColor accessors for every pixel.  The bytes are stored in memory order R, G, B, A (regardless of the
+      endianness of the machine) so an entry can be copied straight into the pixel interleaved output buffer.  */
+
+  for (int32_t i = 0 ; i < NUMSHADES * (NUMHUES + 1) ; i++)
+    {
+      uint8_t rgba[4];
+
+      rgba[0] = options->color_array[i].red ();
+      rgba[1] = options->color_array[i].green ();
+      rgba[2] = options->color_array[i].blue ();
+      rgba[3] = 255;
+
+      memcpy (&color_lut[i], rgba, 4);
+    }
+}
+
+
+
+//!  Do all of the stages in order.  No matter what happens, everything is closed and freed on return.
+
+int32_t chrtrRenderEngine::run (char *chrtr_name, char *output_name, char *area_name, uint8_t contour_flag)
+{
+  int32_t status;
+
+
+  contour_requested = contour_flag;
+
+
+  if ((status = open (chrtr_name, area_name)) == RENDER_SUCCESS &&
+      (status = load ()) == RENDER_SUCCESS &&
+      (status = stats ()) == RENDER_SUCCESS &&
+      (status = createOutput (output_name)) == RENDER_SUCCESS &&
+      (status = render ()) == RENDER_SUCCESS)
+    {
+      if (contour_flag) status = contour ();
+    }
+
+  close ();
+
+  return (status);
+}
+
+
+
+//!  GDAL COMPRESS name of a codec (CODEC_LZW, etc.).
+
+const char *chrtrRenderEngine::codecName (int32_t codec)
+{
+  switch (codec)
+    {
+    case CODEC_DEFLATE:
+      return ("DEFLATE");
+
+    case CODEC_ZSTD:
+      return ("ZSTD");
+
+    case CODEC_LZMA:
+      return ("LZMA");
+    }
+
+  return ("LZW");
+}
+
+
+
+/*!
+  Set the compression codec, predictor, and level creation options (for the GTiff or COG driver).  LZW is left
+  the way it has always been (no predictor) so existing files don't change.  The other codecs use horizontal
+  differencing (PREDICTOR=2) for the 8 bit color bands and the floating point predictor (PREDICTOR=3) for 32 bit
+  grey scale.
+*/
+
+void chrtrRenderEngine::setCompression (char ***papszOptions)
+{
+  QString level = QString::number (options->codec_level);
+
+
+  *papszOptions = CSLSetNameValue (*papszOptions, "COMPRESS", codecName (options->codec));
+
+  if (options->codec == CODEC_LZW) return;
+
+
+  if (options->cog)
+    {
+      *papszOptions = CSLSetNameValue (*papszOptions, "PREDICTOR", "YES");
+      if (options->codec_level) *papszOptions = CSLSetNameValue (*papszOptions, "LEVEL", level.toLatin1 ());
+
+      return;
+    }
+
+
+  *papszOptions = CSLSetNameValue (*papszOptions, "PREDICTOR", options->grey ? "3" : "2");
+
+  if (options->codec_level)
+    {
+      switch (options->codec)
+        {
+        case CODEC_DEFLATE:
+          *papszOptions = CSLSetNameValue (*papszOptions, "ZLEVEL", level.toLatin1 ());
+          break;
+
+        case CODEC_ZSTD:
+          *papszOptions = CSLSetNameValue (*papszOptions, "ZSTD_LEVEL", level.toLatin1 ());
+          break;
+
+        case CODEC_LZMA:
+          *papszOptions = CSLSetNameValue (*papszOptions, "LZMA_PRESET", level.toLatin1 ());
+          break;
+        }
+    }
+}
+
+
+
+/*!
+  Classic TIFF can't be bigger than 4GB and GDAL can't tell how big a compressed file is going to be before it
+  writes it (BIGTIFF=IF_NEEDED only looks at the uncompressed size of uncompressed files).  We estimate the
+  uncompressed size (plus a third for overviews) and, if that's over BIGTIFF_THRESHOLD, ask for a BigTIFF.  The
+  threshold is a little under 4GB since a compressor can make random data slightly bigger.  Below that we leave
+  it to GDAL's IF_SAFER guess.
+*/
+
+void chrtrRenderEngine::setBigTiff (char ***papszOptions)
+{
+  double size = (double) width * (double) height * (double) bands;
+
+  if (options->grey) size *= sizeof (float);
+
+  if (options->overviews && (options->cog || !options->caris)) size *= 4.0 / 3.0;
+
+
+  if (size > BIGTIFF_THRESHOLD)
+    {
+      *papszOptions = CSLSetNameValue (*papszOptions, "BIGTIFF", "YES");
+      message (QString (QObject::tr ("Estimated output size is %1 GB, writing a BigTIFF")).arg (size / 1.0e9, 0, 'f', 1));
+    }
+  else
+    {
+      *papszOptions = CSLSetNameValue (*papszOptions, "BIGTIFF", "IF_SAFER");
+    }
+}
+
+
+
+//!  Returns NVTrue if the overviews for this output (color or grey scale) are averaged, NVFalse for nearest neighbor.
+
+uint8_t chrtrRenderEngine::overviewAverage ()
+{
+  if (options->grey) return (options->ov_grey_resampling == OVERVIEW_AVERAGE);
+
+  return (options->ov_color_resampling == OVERVIEW_AVERAGE);
+}
+
+
+
+/*!
+  Have GDAL compress the tiles (or strips) on a pool of options->compress_threads threads (0 means all of the
+  cores).  Each block is still compressed on its own by the same codec so the output is identical to compressing
+  on the writing thread.
+*/
+
+void chrtrRenderEngine::setCompressThreads (char ***papszOptions)
+{
+  if (options->compress_threads == 1) return;
+
+  if (options->compress_threads <= 0)
+    {
+      *papszOptions = CSLSetNameValue (*papszOptions, "NUM_THREADS", "ALL_CPUS");
+    }
+  else
+    {
+      *papszOptions = CSLSetNameValue (*papszOptions, "NUM_THREADS", QString::number (options->compress_threads).toLatin1 ());
+    }
+}
+
+
+
+//!  Open the CHRTR/CHRTR2 file and figure out the output window (the whole file or the area file MBR).
+
+int32_t chrtrRenderEngine::open (char *chrtr_name, char *area_name)
+{
+  int32_t             header_width, header_height;
+  double              conversion_factor, mid_y_radians;
+  NV_F64_MBR          header_mbr;
+
+
+  close ();
+
+  setColors ();
+
+
+  //  We can only stream if we don't need the whole grid for contouring.
+
+  streaming = NVFalse;
+  if (options->stream && !contour_requested) streaming = NVTrue;
+
+
+  //  GDAL needs tile dimensions that are multiples of 16.
+
+  options->tile_width = qMax (16, (options->tile_width / 16) * 16);
+  options->tile_height = qMax (16, (options->tile_height / 16) * 16);
+
+
+  x_start = 0;
+  y_start = 0;
+
+
+  if (reader.open (chrtr_name, options->chrtr2)) return (setError (RENDER_CHRTR_OPEN_ERROR, reader.errorString ()));
+
+
+  //  If there's no up to date statistics index it will be built by the stats stage.
+
+  if (options->stats_index) index.read (chrtr_name, reader.cols (), reader.rows ());
+
+
+  header_width = width = reader.cols ();
+  header_height = height = reader.rows ();
+
+  header_mbr = reader.bounds ();
+
+  mbr.min_x = header_mbr.wlon;
+  mbr.max_x = header_mbr.elon;
+  mbr.min_y = header_mbr.slat;
+  mbr.max_y = header_mbr.nlat;
+
+  y_cell_degrees = reader.yCellDegrees ();
+  x_cell_degrees = reader.xCellDegrees ();
+
+  null_value = reader.nullValue ();
+
+
+  //  Check for an area file.
+
+  if (area_name != NULL && strlen (area_name))
+    {
+      if (mask.read (area_name))
+        return (setError (RENDER_AREA_FILE_ERROR, QString (QObject::tr ("Error reading area file %1\nReason : %2")).arg
+                          (area_name).arg (mask.errorString ())));
+
+      mbr = mask.bounds ();
+
+
+      if (mbr.min_y > header_mbr.nlat || mbr.max_y < header_mbr.slat || mbr.min_x > header_mbr.elon || mbr.max_x < header_mbr.wlon)
+        return (setError (RENDER_AREA_OUTSIDE_ERROR, QObject::tr ("Specified area is completely outside of the CHRTR bounds!")));
+
+
+      //  Match to nearest cell
+
+      x_start = NINT ((mbr.min_x - header_mbr.wlon) / x_cell_degrees);
+      y_start = NINT ((mbr.min_y - header_mbr.slat) / y_cell_degrees);
+      width = NINT ((mbr.max_x - mbr.min_x) / x_cell_degrees);
+      height = NINT ((mbr.max_y - mbr.min_y) / y_cell_degrees);
+
+
+      //  Adjust to CHRTR bounds if necessary
+
+      if (x_start < 0) x_start = 0;
+      if (y_start < 0) y_start = 0;
+      if (x_start + width > header_width) width = header_width - x_start;
+      if (y_start + height > header_height) height = header_height - y_start;
+
+
+      //  Redefine bounds
+
+      mbr.min_x = header_mbr.wlon + x_start * x_cell_degrees;
+      mbr.min_y = header_mbr.slat + y_start * y_cell_degrees;
+      mbr.max_x = mbr.min_x + width * x_cell_degrees;
+      mbr.max_y = mbr.min_y + height * y_cell_degrees;
+
+
+      //  Rasterize the area polygons so loadRow can null out everything outside of them.
+
+      mask.build (mbr.min_x, mbr.min_y, x_cell_degrees, y_cell_degrees, width, height);
+    }
+
+
+  //  Now that we know the window we can work out which grid cache file we'd use.
+
+  if (options->grid_cache) cache.setKey (options->cache_dir, chrtr_name, area_name, x_start, y_start, width, height, options);
+
+
+  //  Compute cell sizes for sunshading.
+
+  mid_y_radians = (header_mbr.nlat - header_mbr.slat) * 0.0174532925199432957692;
+  conversion_factor = cos (mid_y_radians);
+  x_cell_size = x_cell_degrees * 111120.0 * conversion_factor;
+  y_cell_size = y_cell_degrees * 111120.0;
+
+
+  return (RENDER_SUCCESS);
+}
+
+
+
+//!  Convert a valid Z value, as read, to the output units and depth/elevation.
+
+float chrtrRenderEngine::convertZ (float z_value)
+{
+  if (options->units)
+    {
+      if (options->dumb)
+        {
+          z_value /= 1.875;
+        }
+      else
+        {
+          z_value /= 1.8288;
+        }
+    }
+
+
+  if (options->elev) z_value = -z_value;
+
+
+  return (z_value);
+}
+
+
+
+/*!
+  Read row "row" (0 is the southernmost row) of the output window into dest, converting units and
+  depth/elevation.  Empty cells, and cells outside of the area polygons, are set to null_value so they are never
+  shaded, colored, or contoured.  Rows that are completely outside of the polygons aren't read at all.
+*/
+
+void chrtrRenderEngine::loadRow (int32_t row, float *dest)
+{
+  if (mask.active ())
+    {
+      if (mask.empty (row))
+        {
+          for (int32_t j = 0 ; j < width ; j++) dest[j] = null_value;
+          return;
+        }
+
+      reader.readRow (y_start + row, x_start, width, dest);
+
+      mask.apply (row, dest, null_value);
+    }
+  else
+    {
+      reader.readRow (y_start + row, x_start, width, dest);
+    }
+
+
+  for (int32_t j = 0 ; j < width ; j++)
+    {
+      if (dest[j] < null_value)
+        {
+          dest[j] = convertZ (dest[j]);
+        }
+      else
+        {
+          dest[j] = null_value;
+        }
+    }
+}
+
+
+
+//!  Get output row k (0 is the northernmost row) from the grid array or, if we're streaming, from the file.
+
+void chrtrRenderEngine::fetchRow (int32_t k, float *dest)
+{
+  int32_t i = height - 1 - k;
+
+  if (streaming)
+    {
+      loadRow (i, dest);
+    }
+  else
+    {
+      memcpy (dest, &ar[(size_t) i * width], width * sizeof (float));
+    }
+}
+
+
+
+/*!
+  Load the grid array.  If the grid is in the grid cache it's mapped in (even if we were going to stream since the
+  kernel will only page in what we use) and the min and max come with it.  When streaming there's nothing to do
+  here.
+*/
+
+int32_t chrtrRenderEngine::load ()
+{
+  if (options->grid_cache && (ar = cache.map (&min_z, &max_z)) != NULL)
+    {
+      streaming = NVFalse;
+
+      message (QObject::tr ("Using cached grid %1").arg (cache.fileName ()));
+
+      return (RENDER_SUCCESS);
+    }
+
+
+  if (streaming) return (RENDER_SUCCESS);
+
+
+  ar = (float *) calloc ((size_t) width * (size_t) height, sizeof (float));
+  if (ar == NULL)
+    {
+      if (contour_requested)
+        return (setError (RENDER_MEMORY_ERROR, QObject::tr ("Unable to allocate grid array : ") + QString (strerror (errno))));
+
+
+      //  We don't need the whole grid if we're not contouring so we'll just read it twice.
+
+      message (QObject::tr ("Not enough memory for the grid array, switching to streaming mode"));
+      streaming = NVTrue;
+
+      return (RENDER_SUCCESS);
+    }
+
+
+  stageStart (RENDER_LOAD_STAGE, height);
+
+  for (int32_t i = 0 ; i < height ; i++)
+    {
+      loadRow (i, &ar[(size_t) i * width]);
+
+      stageProgress (RENDER_LOAD_STAGE, i + 1);
+    }
+
+
+  return (RENDER_SUCCESS);
+}
+
+
+
+/*!
+  Get the min/max for the output window from the statistics index, building the index first (one pass through the
+  whole file) if there isn't an up to date one.  The blocks that are entirely inside of the window (and, if there's
+  an area file, entirely inside of the polygons) are combined and only the cells of the other blocks that overlap
+  the window are read.  The index holds Z as read so the min/max are converted at the end.  The conversion keeps
+  (or, for elevations, reverses) the order so this gives exactly the same min/max as scanning the converted rows.
+  Returns -1, without changing min_z and max_z, if we can't allocate a row buffer.
+*/
+
+int32_t chrtrRenderEngine::indexStats ()
+{
+  int32_t file_width = reader.cols (), file_height = reader.rows ();
+  STATS_BLOCK total;
+  int64_t whole_blocks = 0, cells_read = 0;
+  QVector<int32_t> segments;
+
+
+  float *row = (float *) malloc (file_width * sizeof (float));
+  if (row == NULL) return (-1);
+
+
+  if (!index.valid ())
+    {
+      index.start ();
+
+      stageStart (RENDER_LOAD_STAGE, file_height);
+
+      for (int32_t i = 0 ; i < file_height ; i++)
+        {
+          reader.readRow (i, 0, file_width, row);
+
+          index.addRow (i, row, null_value);
+
+          stageProgress (RENDER_LOAD_STAGE, i + 1);
+        }
+
+
+      //  We can still use the index for this run if it couldn't be saved.
+
+      if (index.write ())
+        {
+          message (QObject::tr ("Statistics index not written : %1").arg (index.errorString ()));
+        }
+      else
+        {
+          message (QObject::tr ("Saved statistics index %1").arg (index.fileName ()));
+        }
+    }
+
+
+  statsIndex::init (&total);
+
+  int32_t bx_start = x_start / STATS_BLOCK_SIZE, bx_end = (x_start + width - 1) / STATS_BLOCK_SIZE;
+  int32_t by_start = y_start / STATS_BLOCK_SIZE, by_end = (y_start + height - 1) / STATS_BLOCK_SIZE;
+
+  stageStart (RENDER_LOAD_STAGE, by_end - by_start + 1);
+
+  for (int32_t by = by_start ; by <= by_end ; by++)
+    {
+      //  File rows in this row of blocks and the part of them in the window.
+
+      int32_t block_r0 = by * STATS_BLOCK_SIZE, block_r1 = qMin (block_r0 + STATS_BLOCK_SIZE, file_height);
+      int32_t r0 = qMax (block_r0, y_start), r1 = qMin (block_r1, y_start + height);
+
+
+      //  Combine the whole blocks and make a list of the (file) column ranges we have to read for the rest.
+
+      segments.clear ();
+
+      for (int32_t bx = bx_start ; bx <= bx_end ; bx++)
+        {
+          int32_t block_c0 = bx * STATS_BLOCK_SIZE, block_c1 = qMin (block_c0 + STATS_BLOCK_SIZE, file_width);
+          int32_t c0 = qMax (block_c0, x_start), c1 = qMin (block_c1, x_start + width);
+
+          uint8_t whole = (r0 == block_r0 && r1 == block_r1 && c0 == block_c0 && c1 == block_c1);
+
+          if (whole && mask.active ())
+            {
+              for (int32_t r = r0 ; r < r1 && whole ; r++) whole = mask.covers (r - y_start, c0 - x_start, c1 - x_start);
+            }
+
+
+          if (whole)
+            {
+              statsIndex::combine (&total, index.block (bx, by));
+              whole_blocks++;
+            }
+          else if (segments.size () && segments.last () == c0)
+            {
+              segments.last () = c1;
+            }
+          else
+            {
+              segments.append (c0);
+              segments.append (c1);
+            }
+        }
+
+
+      for (int32_t r = r0 ; r < r1 && segments.size () ; r++)
+        {
+          if (mask.active () && mask.empty (r - y_start)) continue;
+
+          for (int32_t s = 0 ; s < segments.size () ; s += 2)
+            {
+              int32_t count = segments[s + 1] - segments[s];
+
+              reader.readRow (r, segments[s], count, row);
+
+              if (mask.active ()) mask.applySegment (r - y_start, segments[s] - x_start, count, row, null_value);
+
+              for (int32_t j = 0 ; j < count ; j++)
+                {
+                  if (row[j] < null_value) statsIndex::addValue (&total, row[j]);
+                }
+
+              cells_read += count;
+            }
+        }
+
+      stageProgress (RENDER_LOAD_STAGE, by - by_start + 1);
+    }
+
+  free (row);
+
+
+  if (total.count)
+    {
+      if (options->elev)
+        {
+          min_z = convertZ (total.max_z);
+          max_z = convertZ (total.min_z);
+        }
+      else
+        {
+          min_z = convertZ (total.min_z);
+          max_z = convertZ (total.max_z);
+        }
+    }
+
+
+  message (QObject::tr ("Min/max from the statistics index (%1 whole blocks, %2 cells read)").arg ((qlonglong) whole_blocks)
+           .arg ((qlonglong) cells_read));
+
+
+  return (0);
+}
+
+
+
+/*!
+  Compute the min/max and color ranges.  If we're streaming this is a read only pass through the file, one row at
+  a time, otherwise we just scan the grid array.  If the grid came from the grid cache we already have the min/max.
+  Otherwise, if the grid cache is on, the rows are saved to the cache as they're scanned.  If the statistics index
+  is on and we're streaming (but not into the grid cache) the min/max come from the index instead (see indexStats).
+  The index isn't used when the grid is in memory since scanning the array is cheaper than reading the edge cells
+  of the blocks from the file again.
+*/
+
+int32_t chrtrRenderEngine::stats ()
+{
+  if (!cache.mapped ())
+    {
+      uint8_t caching = NVFalse;
+
+      if (options->grid_cache)
+        {
+          if (cache.create (null_value))
+            {
+              message (QObject::tr ("Grid cache not written : %1").arg (cache.errorString ()));
+            }
+          else
+            {
+              caching = NVTrue;
+            }
+        }
+
+
+      min_z = null_value;
+      max_z = -null_value;
+
+
+      //  When streaming, unless we have to read all of the rows anyway (to save them in the grid cache), the
+      //  statistics index can give us the min/max while reading few, if any, of them.
+
+      if (!options->stats_index || !streaming || caching || indexStats ())
+        {
+          if (streaming)
+            {
+              float *row = (float *) malloc (width * sizeof (float));
+              if (row == NULL)
+                {
+                  cache.discard ();
+                  return (setError (RENDER_MEMORY_ERROR, QObject::tr ("Unable to allocate row buffer : ") + QString (strerror (errno))));
+                }
+
+
+              stageStart (RENDER_LOAD_STAGE, height);
+
+              for (int32_t i = 0 ; i < height ; i++)
+                {
+                  loadRow (i, row);
+
+                  for (int32_t j = 0 ; j < width ; j++)
+                    {
+                      if (row[j] < null_value)
+                        {
+                          min_z = qMin (min_z, row[j]);
+                          max_z = qMax (max_z, row[j]);
+                        }
+                    }
+
+                  if (caching && cache.write (row, 1))
+                    {
+                      message (QObject::tr ("Grid cache not written : %1").arg (cache.errorString ()));
+                      caching = NVFalse;
+                    }
+
+                  stageProgress (RENDER_LOAD_STAGE, i + 1);
+                }
+
+              free (row);
+            }
+          else
+            {
+              size_t ar_size = (size_t) width * (size_t) height;
+
+              for (size_t i = 0 ; i < ar_size ; i++)
+                {
+                  if (ar[i] < null_value)
+                    {
+                      min_z = qMin (min_z, ar[i]);
+                      max_z = qMax (max_z, ar[i]);
+                    }
+                }
+            }
+        }
+
+
+      //  The grid array is complete so it's saved in one go.
+
+      if (caching && !streaming && cache.write (ar, height))
+        {
+          message (QObject::tr ("Grid cache not written : %1").arg (cache.errorString ()));
+          caching = NVFalse;
+        }
+
+
+      if (caching)
+        {
+          if (cache.finish (min_z, max_z))
+            {
+              message (QObject::tr ("Grid cache not written : %1").arg (cache.errorString ()));
+            }
+          else
+            {
+              message (QObject::tr ("Saved grid to cache %1").arg (cache.fileName ()));
+            }
+        }
+    }
+
+
+  if (options->restart && min_z < 0.0)
+    {
+      range[0] = -min_z;
+      range[1] = max_z;
+
+      cross_zero = NVTrue;
+    }
+  else
+    {
+      range[0] = max_z - min_z;
+
+      cross_zero = NVFalse;
+    }
+
+
+  return (RENDER_SUCCESS);
+}
+
+
+
+//!  Create the output GeoTIFF.
+
+int32_t chrtrRenderEngine::createOutput (char *output_name)
+{
+  GDALDriver          *gt;
+  char                **papszOptions = NULL;
+
+
+  strcpy (name, output_name);
+
+  if (strcmp (&name[strlen (name) - 4], ".tif")) strcat (name, ".tif");
+
+
+  GDALAllRegister ();
+
+  gt = GetGDALDriverManager ()->GetDriverByName ("GTiff");
+  if (!gt) return (setError (RENDER_GDAL_DRIVER_ERROR, QObject::tr ("Could not get GTiff driver")));
+
+
+  bands = 3;
+  if (options->transparent) bands = 4;
+  if (options->grey) bands = 1;
+
+
+  transform[0] = mbr.min_x;
+  transform[1] = x_cell_degrees;
+  transform[2] = 0.0;
+  transform[3] = mbr.max_y;
+  transform[4] = 0.0;
+  transform[5] = -y_cell_degrees;
+
+
+  //  Cloud optimized GeoTIFFs are written with the COG driver by renderCog so there's nothing to create here.
+
+  if (options->cog)
+    {
+      if (!GetGDALDriverManager ()->GetDriverByName ("COG"))
+        return (setError (RENDER_GDAL_DRIVER_ERROR, QObject::tr ("Could not get COG driver (GDAL 3.1 or newer is required)")));
+
+      num_overviews = 0;
+
+      return (RENDER_SUCCESS);
+    }
+
+
+  //  Stupid Caris software can't read normal files!
+
+  if (options->caris)
+    {
+      papszOptions = CSLSetNameValue (papszOptions, "COMPRESS", "PACKBITS");
+    }
+  else
+    {
+      if (options->tiled)
+        {
+          papszOptions = CSLSetNameValue (papszOptions, "TILED", "YES");
+          papszOptions = CSLSetNameValue (papszOptions, "BLOCKXSIZE", QString::number (options->tile_width).toLatin1 ());
+          papszOptions = CSLSetNameValue (papszOptions, "BLOCKYSIZE", QString::number (options->tile_height).toLatin1 ());
+        }
+      else
+        {
+          papszOptions = CSLSetNameValue (papszOptions, "TILED", "NO");
+        }
+
+      setCompression (&papszOptions);
+    }
+
+
+  setCompressThreads (&papszOptions);
+  setBigTiff (&papszOptions);
+
+
+  //  We write all of the color bands at once from a packed RGB(A) buffer so store them the same way.
+
+  if (!options->grey) papszOptions = CSLSetNameValue (papszOptions, "INTERLEAVE", "PIXEL");
+
+  if (options->grey)
+    {
+      df = gt->Create (name, width, height, bands, GDT_Float32, papszOptions);
+    }
+  else
+    {
+      df = gt->Create (name, width, height, bands, GDT_Byte, papszOptions);
+    }
+
+  CSLDestroy (papszOptions);
+
+  if (df == NULL) return (setError (RENDER_GDAL_CREATE_ERROR, QString (QObject::tr ("Could not create %1")).arg (name)));
+
+
+  df->SetGeoTransform (transform);
+
+  df->SetProjection (wkt_string);
+
+
+  for (int32_t i = 0 ; i < bands ; i++) bd[i] = df->GetRasterBand (i + 1);
+
+
+  if (options->grey) bd[0]->SetNoDataValue (null_value);
+
+
+  /*  Add the (empty) overview levels.  Using the NONE resampling method just creates the overview directories
+      without computing anything.  The render stage fills them in from the rows it has in memory so we don't have
+      to read the whole file back in afterwards (like gdaladdo does).  We keep halving the size until the image
+      fits in OVERVIEW_MIN_SIZE pixels.  Caris doesn't understand overviews.  */
+
+  num_overviews = 0;
+
+  if (options->overviews && !options->caris)
+    {
+      for (int32_t factor = 2 ; num_overviews < MAX_OVERVIEWS && qMax (width, height) / (factor / 2) > OVERVIEW_MIN_SIZE ;
+           factor *= 2)
+        overview_factor[num_overviews++] = factor;
+
+      if (num_overviews && df->BuildOverviews ("NONE", num_overviews, overview_factor, 0, NULL, NULL, NULL) == CE_Failure)
+        {
+          message (QObject::tr ("Unable to add overviews to the GeoTIFF, continuing without them"));
+          num_overviews = 0;
+        }
+    }
+
+
+  return (RENDER_SUCCESS);
+}
+
+
+
+/*!
+  Sunshade and color one row.  current_row is the row being colored and next_row is the row to the south of it (the
+  next row going north to south).  This is the same pairing as the old per pixel sunshade (next_row, current_row,
+  ...) loop.  The pixels are packed (RGB or RGBA, depending on the number of bands) into "pixels".  Empty cells get 0
+  in all channels.  The shade factors for the whole row are computed first, into "shade", by sunshade_row and then
+  turned into color table indices, in "index", by color_index_row.  Both are width values of scratch space.
+*/
+
+void chrtrRenderEngine::shadeRow (float *next_row, float *current_row, uint8_t *pixels, float *shade, int32_t *index)
+{
+  sunshade_row (next_row, current_row, width, &options->sunopts, x_cell_size, y_cell_size, null_value, shade);
+
+  color_index_row (current_row, shade, width, min_z, range, cross_zero, null_value, index);
+
+
+  for (int32_t j = 0 ; j < width ; j++)
+    {
+      uint32_t rgba = 0;
+
+      if (index[j] >= 0) rgba = color_lut[index[j]];
+
+      memcpy (&pixels[j * bands], &rgba, bands);
+    }
+}
+
+
+
+/*!
+  Write "rows" output rows starting at output row k_start (0 is the northernmost row).  The buffers hold the rows
+  one after the other.  For grey scale output only grey_rows is used, otherwise pixels holds packed, pixel
+  interleaved, RGB or RGBA and all of the bands are written with a single dataset RasterIO call.  The render stage
+  always calls this with chunks that are a whole number of tile rows tall (except for the last chunk) so GDAL gets
+  complete blocks to compress.
+*/
+
+int32_t chrtrRenderEngine::writeRows (int32_t k_start, int32_t rows, float *grey_rows, uint8_t *pixels)
+{
+  CPLErr err;
+
+
+  if (options->grey)
+    {
+      err = bd[0]->RasterIO (GF_Write, 0, k_start, width, rows, grey_rows, width, rows, GDT_Float32, 0, 0);
+    }
+  else
+    {
+      err = df->RasterIO (GF_Write, 0, k_start, width, rows, pixels, width, rows, GDT_Byte, bands, NULL, bands, (GSpacing) bands * width, 1);
+    }
+
+  if (err == CE_Failure) return (setError (RENDER_WRITE_ERROR, QString (QObject::tr ("Failed a TIFF write - rows %1 to %2")).arg
+                                           (k_start).arg (k_start + rows - 1)));
+
+
+  return (RENDER_SUCCESS);
+}
+
+
+
+/*!
+  Sunshade and color "count" rows from a chunk buffer into the band buffers.  Row 0 of rows_buf is the halo (the row
+  to the north of the first row).  Row r of rows_buf is the row that gets colored into row r of the packed pixel
+  buffer and row r + 1, the row to the south of it, is its sunshade neighbor.  So, like the original single row loop,
+  each output row of a color image shows the row to the north of the one written for grey scale (and the
+  northernmost row is repeated).  This only reads rows_buf so any number of these can run at the same time on
+  different bands of the same chunk.  Since the halo always comes along with the band the result is the same no
+  matter how the rows are split up.
+*/
+
+void chrtrRenderEngine::shadeRows (int32_t count, float *rows_buf, uint8_t *pixels, float *shade, int32_t *index)
+{
+  for (int32_t r = 0 ; r < count ; r++)
+    {
+      size_t offset = (size_t) r * width;
+
+      shadeRow (&rows_buf[offset + width], &rows_buf[offset], &pixels[offset * bands], shade, index);
+    }
+}
+
+
+
+shadeThread::shadeThread ()
+{
+  engine = NULL;
+  count = 0;
+  rows_buf = NULL;
+  pixels = NULL;
+  shade = NULL;
+  index = NULL;
+}
+
+
+
+void shadeThread::setup (chrtrRenderEngine *eng, int32_t rows, float *buf, uint8_t *pix, float *shd, int32_t *ndx)
+{
+  engine = eng;
+  count = rows;
+  rows_buf = buf;
+  pixels = pix;
+  shade = shd;
+  index = ndx;
+}
+
+
+
+void shadeThread::run ()
+{
+  engine->shadeRows (count, rows_buf, pixels, shade, index);
+}
+
+
+
+overviewThread::overviewThread ()
+{
+  for (int32_t i = 0 ; i < 4 ; i++) ov[i] = NULL;
+  bands = factor = width = height = ov_width = acc_rows = out_start = out_rows = k_start = count = 0;
+  is_grey = average = NVFalse;
+  null_value = 0.0;
+  grey_in = grey_out = NULL;
+  pixels_in = pixels_out = NULL;
+  sum = NULL;
+  hits = NULL;
+}
+
+
+
+overviewThread::~overviewThread ()
+{
+  if (grey_out) free (grey_out);
+  if (pixels_out) free (pixels_out);
+  if (sum) free (sum);
+  if (hits) free (hits);
+}
+
+
+
+/*!
+  Set up one overview level.  band holds the overview band (of this level) for each of the num_bands bands,
+  ov_factor is the reduction factor, and max_rows is the most full resolution rows we'll ever get in one chunk.
+  If avg is NVFalse each output pixel is the center pixel of its block (nearest neighbor) instead of the average.
+  Returns -1 if we can't allocate the buffers.
+*/
+
+int32_t overviewThread::setup (GDALRasterBand **band, int32_t num_bands, uint8_t grey, uint8_t avg, int32_t ov_factor,
+                               int32_t full_width, int32_t full_height, float null, int32_t max_rows)
+{
+  int32_t             max_out, channels;
+
+
+  for (int32_t i = 0 ; i < num_bands ; i++) ov[i] = band[i];
+  bands = num_bands;
+  is_grey = grey;
+  average = avg;
+  factor = ov_factor;
+  width = full_width;
+  height = full_height;
+  null_value = null;
+  ov_width = ov[0]->GetXSize ();
+  acc_rows = out_start = out_rows = 0;
+
+
+  //  A chunk can finish at most one more overview row than it has whole blocks of rows.
+
+  max_out = max_rows / factor + 2;
+
+
+  //  We average the color channels, the alpha channel (if any) just says whether there was any data.
+
+  if (average)
+    {
+      channels = 1;
+      if (!is_grey) channels = 3;
+
+      sum = (double *) calloc ((size_t) ov_width * channels, sizeof (double));
+      hits = (uint32_t *) calloc (ov_width, sizeof (uint32_t));
+
+      if (sum == NULL || hits == NULL) return (-1);
+    }
+
+  if (is_grey)
+    {
+      grey_out = (float *) malloc ((size_t) ov_width * max_out * sizeof (float));
+      if (grey_out == NULL) return (-1);
+    }
+  else
+    {
+      pixels_out = (uint8_t *) malloc ((size_t) ov_width * max_out * bands);
+      if (pixels_out == NULL) return (-1);
+    }
+
+
+  return (0);
+}
+
+
+
+/*!
+  Hand the thread the next chunk of full resolution rows.  start is the output row (0 is north) of the first row.
+  grey_rows is used for grey scale output and pix (packed RGB or RGBA) for color.
+*/
+
+void overviewThread::setChunk (int32_t start, int32_t rows, float *grey_rows, uint8_t *pix)
+{
+  k_start = start;
+  count = rows;
+  grey_in = grey_rows;
+  pixels_in = pix;
+}
+
+
+
+/*!
+  Add one full resolution row to the block sums.  For nearest neighbor we just copy the center pixel of each block
+  into the output row.  Rows up to the center row overwrite it so a short last block gets its last row.
+*/
+
+void overviewThread::addRow (float *grey_row, uint8_t *pixel_row)
+{
+  if (!average)
+    {
+      if (acc_rows <= factor / 2)
+        {
+          for (int32_t o = 0 ; o < ov_width ; o++)
+            {
+              int32_t j = qMin (width - 1, o * factor + factor / 2);
+
+              if (is_grey)
+                {
+                  grey_out[(size_t) out_rows * ov_width + o] = grey_row[j];
+                }
+              else
+                {
+                  memcpy (&pixels_out[((size_t) out_rows * ov_width + o) * bands], &pixel_row[j * bands], bands);
+                }
+            }
+        }
+
+      acc_rows++;
+      return;
+    }
+
+
+  for (int32_t o = 0 ; o < ov_width ; o++)
+    {
+      int32_t start = o * factor, end = qMin (width, start + factor);
+
+      if (is_grey)
+        {
+          for (int32_t j = start ; j < end ; j++)
+            {
+              if (grey_row[j] < null_value)
+                {
+                  sum[o] += grey_row[j];
+                  hits[o]++;
+                }
+            }
+        }
+      else
+        {
+          double *rgb = &sum[o * 3];
+
+          for (int32_t j = start ; j < end ; j++)
+            {
+              uint8_t *pixel = &pixel_row[j * bands];
+
+              if (bands == 4 && !pixel[3]) continue;
+
+              rgb[0] += pixel[0];
+              rgb[1] += pixel[1];
+              rgb[2] += pixel[2];
+              hits[o]++;
+            }
+        }
+    }
+
+  acc_rows++;
+}
+
+
+
+//!  Turn the block sums into the next overview row and clear them.
+
+void overviewThread::finishRow ()
+{
+  if (!average)
+    {
+      acc_rows = 0;
+      out_rows++;
+      return;
+    }
+
+
+  if (is_grey)
+    {
+      float *row = &grey_out[(size_t) out_rows * ov_width];
+
+      for (int32_t o = 0 ; o < ov_width ; o++)
+        {
+          row[o] = null_value;
+          if (hits[o]) row[o] = (float) (sum[o] / (double) hits[o]);
+        }
+
+      memset (sum, 0, ov_width * sizeof (double));
+    }
+  else
+    {
+      uint8_t *row = &pixels_out[(size_t) out_rows * ov_width * bands];
+
+      for (int32_t o = 0 ; o < ov_width ; o++)
+        {
+          uint8_t *pixel = &row[o * bands];
+
+          if (hits[o])
+            {
+              for (int32_t c = 0 ; c < 3 ; c++) pixel[c] = (uint8_t) NINT (sum[o * 3 + c] / (double) hits[o]);
+              if (bands == 4) pixel[3] = 255;
+            }
+          else
+            {
+              memset (pixel, 0, bands);
+            }
+        }
+
+      memset (sum, 0, ov_width * 3 * sizeof (double));
+    }
+
+  memset (hits, 0, ov_width * sizeof (uint32_t));
+
+  acc_rows = 0;
+  out_rows++;
+}
+
+
+
+void overviewThread::run ()
+{
+  for (int32_t r = 0 ; r < count ; r++)
+    {
+      if (is_grey)
+        {
+          addRow (&grey_in[(size_t) r * width], NULL);
+        }
+      else
+        {
+          addRow (NULL, &pixels_in[(size_t) r * width * bands]);
+        }
+
+
+      //  The last overview row may be made from fewer than factor rows.
+
+      if (acc_rows == factor || k_start + r == height - 1) finishRow ();
+    }
+}
+
+
+
+//!  Write the overview rows finished so far.  Only call this from the thread that owns the dataset.
+
+CPLErr overviewThread::flush ()
+{
+  CPLErr err = CE_None;
+
+
+  if (!out_rows) return (err);
+
+  if (is_grey)
+    {
+      err = ov[0]->RasterIO (GF_Write, 0, out_start, ov_width, out_rows, grey_out, ov_width, out_rows, GDT_Float32, 0, 0);
+    }
+  else
+    {
+      for (int32_t b = 0 ; b < bands && err != CE_Failure ; b++)
+        err = ov[b]->RasterIO (GF_Write, 0, out_start, ov_width, out_rows, &pixels_out[b], ov_width, out_rows, GDT_Byte, bands,
+                               (GSpacing) bands * ov_width);
+    }
+
+  out_start += out_rows;
+  out_rows = 0;
+
+  return (err);
+}
+
+
+
+blockQueue::blockQueue ()
+{
+  closed = NVFalse;
+}
+
+
+
+//!  Add a block to the queue.  NULL is used to tell a worker to quit.  Does nothing once the queue is closed.
+
+void blockQueue::push (RENDER_BLOCK *block)
+{
+  QMutexLocker lock (&mutex);
+
+  if (closed) return;
+
+  queue.enqueue (block);
+  cond.wakeOne ();
+}
+
+
+
+//!  Wait for a block and take it off of the queue.  Returns NULL if the queue has been closed.
+
+RENDER_BLOCK *blockQueue::pop ()
+{
+  QMutexLocker lock (&mutex);
+
+  while (queue.isEmpty () && !closed) cond.wait (&mutex);
+
+  if (closed) return (NULL);
+
+  return (queue.dequeue ());
+}
+
+
+
+//!  Close the queue and wake up anybody waiting on it.
+
+void blockQueue::close ()
+{
+  QMutexLocker lock (&mutex);
+
+  closed = NVTrue;
+  cond.wakeAll ();
+}
+
+
+
+blockReader::blockReader ()
+{
+  engine = NULL;
+  free_queue = render_queue = NULL;
+  height = band_rows = num_workers = 0;
+}
+
+
+
+void blockReader::setup (chrtrRenderEngine *eng, blockQueue *free_blocks, blockQueue *render_blocks, int32_t rows,
+                         int32_t block_rows, int32_t workers)
+{
+  engine = eng;
+  free_queue = free_blocks;
+  render_queue = render_blocks;
+  height = rows;
+  band_rows = block_rows;
+  num_workers = workers;
+}
+
+
+
+//!  Fill free blocks, north to south, and queue them for rendering.  Then tell the workers to quit.
+
+void blockReader::run ()
+{
+  for (int32_t seq = 0, k_start = 0 ; k_start < height ; seq++, k_start += band_rows)
+    {
+      RENDER_BLOCK *block = free_queue->pop ();
+
+      if (block == NULL) return;
+
+      block->seq = seq;
+      block->k_start = k_start;
+      block->rows = qMin (band_rows, height - k_start);
+
+      engine->fetchBlock (block);
+
+      render_queue->push (block);
+    }
+
+  for (int32_t t = 0 ; t < num_workers ; t++) render_queue->push (NULL);
+}
+
+
+
+blockRenderer::blockRenderer ()
+{
+  engine = NULL;
+  in_queue = out_queue = NULL;
+  shade = NULL;
+  index = NULL;
+}
+
+
+
+void blockRenderer::setup (chrtrRenderEngine *eng, blockQueue *in, blockQueue *out, float *shd, int32_t *ndx)
+{
+  engine = eng;
+  in_queue = in;
+  out_queue = out;
+  shade = shd;
+  index = ndx;
+}
+
+
+
+void blockRenderer::run ()
+{
+  RENDER_BLOCK *block;
+
+
+  while ((block = in_queue->pop ()) != NULL)
+    {
+      engine->shadeBlock (block, shade, index);
+      out_queue->push (block);
+    }
+}
+
+
+
+//!  Figure out the number of render threads and the number of rows each thread works on at a time.
+
+void chrtrRenderEngine::setChunking ()
+{
+  num_threads = options->num_threads;
+  if (num_threads <= 0) num_threads = QThread::idealThreadCount ();
+  if (num_threads < 1) num_threads = 1;
+  if (num_threads > MAX_RENDER_THREADS) num_threads = MAX_RENDER_THREADS;
+
+  band_rows = RENDER_BAND_ROWS;
+  if ((options->tiled && !options->caris) || options->cog)
+    band_rows = ((RENDER_BAND_ROWS + options->tile_height - 1) / options->tile_height) * options->tile_height;
+
+  chunk_rows = band_rows * num_threads;
+}
+
+
+
+/*!
+  Allocate the chunk buffers and the shade threads for renderCog.  The output is done in chunks of
+  RENDER_BAND_ROWS rows (rounded up to a whole number of tiles if we're writing a tiled GeoTIFF) per thread.  The
+  chunk buffer (rows_buf) has one extra row at the top for the sunshade halo.  Each thread also gets its own row
+  of scratch space for the shade factors and color indices.
+*/
+
+int32_t chrtrRenderEngine::allocRender ()
+{
+  setChunking ();
+
+
+  rows_buf = (float *) malloc ((size_t) (chunk_rows + 1) * width * sizeof (float));
+
+  if (!options->grey)
+    {
+      pixels = (uint8_t *) malloc ((size_t) chunk_rows * width * bands);
+      shade_buf = (float *) malloc ((size_t) num_threads * width * sizeof (float));
+      index_buf = (int32_t *) malloc ((size_t) num_threads * width * sizeof (int32_t));
+
+      if (num_threads > 1) thread = new shadeThread[num_threads];
+
+      if (pixels == NULL || shade_buf == NULL || index_buf == NULL)
+        return (setError (RENDER_MEMORY_ERROR, QObject::tr ("Unable to allocate row buffers : ") + QString (strerror (errno))));
+    }
+
+  if (rows_buf == NULL) return (setError (RENDER_MEMORY_ERROR, QObject::tr ("Unable to allocate row buffers : ") + QString (strerror (errno))));
+
+
+  return (RENDER_SUCCESS);
+}
+
+
+
+void chrtrRenderEngine::freeRender ()
+{
+  if (thread) delete[] thread;
+  if (rows_buf) free (rows_buf);
+  if (pixels) free (pixels);
+  if (shade_buf) free (shade_buf);
+  if (index_buf) free (index_buf);
+
+  thread = NULL;
+  rows_buf = shade_buf = NULL;
+  pixels = NULL;
+  index_buf = NULL;
+}
+
+
+
+/*!
+  Fetch "rows" output rows starting at output row k_start (0 is north) into rows_buf and, unless we're writing
+  grey scale, sunshade and color them into pixels.  The grid is stored south to north, the GeoTIFF north to south.
+  Row 0 of rows_buf is the sunshade halo, the row to the north of k_start (or a copy of row k_start for the
+  northernmost chunk) so chunks can be rendered in any order.  Each thread shades its own band of the chunk.
+*/
+
+void chrtrRenderEngine::renderChunk (int32_t k_start, int32_t rows)
+{
+  for (int32_t r = 0 ; r < rows ; r++) fetchRow (k_start + r, &rows_buf[(size_t) (r + 1) * width]);
+
+  if (!k_start)
+    {
+      memcpy (rows_buf, &rows_buf[width], width * sizeof (float));
+    }
+  else
+    {
+      fetchRow (k_start - 1, rows_buf);
+    }
+
+
+  if (options->grey) return;
+
+
+  if (num_threads == 1)
+    {
+      shadeRows (rows, rows_buf, pixels, shade_buf, index_buf);
+    }
+  else
+    {
+      int32_t started = 0;
+
+      for (int32_t t = 0 ; t < num_threads ; t++)
+        {
+          int32_t band_start = t * band_rows;
+
+          if (band_start >= rows) break;
+
+          size_t offset = (size_t) band_start * width;
+
+          thread[t].setup (this, qMin (band_rows, rows - band_start), &rows_buf[offset], &pixels[offset * bands],
+                           &shade_buf[(size_t) t * width], &index_buf[(size_t) t * width]);
+          thread[t].start ();
+          started++;
+        }
+
+      for (int32_t t = 0 ; t < started ; t++) thread[t].wait ();
+    }
+}
+
+
+
+//!  Fetch the rows (and the sunshade halo row) of a pipeline block.  Called by the reader thread.
+
+void chrtrRenderEngine::fetchBlock (RENDER_BLOCK *block)
+{
+  for (int32_t r = 0 ; r < block->rows ; r++) fetchRow (block->k_start + r, &block->rows_buf[(size_t) (r + 1) * width]);
+
+  if (!block->k_start)
+    {
+      memcpy (block->rows_buf, &block->rows_buf[width], width * sizeof (float));
+    }
+  else
+    {
+      fetchRow (block->k_start - 1, block->rows_buf);
+    }
+}
+
+
+
+//!  Sunshade and color a pipeline block.  Called by the render workers.  Grey scale blocks pass straight through.
+
+void chrtrRenderEngine::shadeBlock (RENDER_BLOCK *block, float *shade, int32_t *index)
+{
+  if (!options->grey) shadeRows (block->rows, block->rows_buf, block->pixels, shade, index);
+}
+
+
+
+/*!
+  Sunshade, color, and write the GeoTIFF.  This is a pipeline so that reading, shading, and compressing/writing
+  all happen at the same time:
+
+  - a reader thread (blockReader) fetches blocks of band_rows rows (from the grid array or, when streaming, from
+    the file) into free blocks and queues them for rendering
+  - num_threads render workers (blockRenderer) sunshade and color the blocks
+  - this thread (the writer) writes the blocks in order, with the overview levels being computed on their own
+    threads while each block is written, and then hands the block back to the reader
+
+  The blocks come from a fixed pool of RENDER_QUEUE_DEPTH blocks per worker so the reader can only get that far
+  ahead of the writer.  That keeps memory use capped no matter how big the grid is.  The writer has to be the
+  calling thread since only one thread can write to the GDAL dataset and the progress callbacks may update the
+  GUI.  Since the blocks are written in order the GeoTIFF is the same no matter how many threads are used.
+*/
+
+int32_t chrtrRenderEngine::render ()
+{
+  int32_t             status = RENDER_SUCCESS, num_blocks, pool_size, next_seq = 0;
+  RENDER_BLOCK        *pool = NULL;
+  overviewThread      *overview = NULL;
+  blockReader         read_thread;
+  blockRenderer       *workers = NULL;
+  blockQueue          free_queue, render_queue, write_queue;
+  QMap<int32_t, RENDER_BLOCK *> pending;
+
+
+  if (options->cog) return (renderCog ());
+
+
+  setChunking ();
+
+  num_blocks = (height + band_rows - 1) / band_rows;
+  pool_size = qMin (num_blocks, num_threads * RENDER_QUEUE_DEPTH);
+
+
+  pool = (RENDER_BLOCK *) calloc (pool_size, sizeof (RENDER_BLOCK));
+  if (!options->grey)
+    {
+      shade_buf = (float *) malloc ((size_t) num_threads * width * sizeof (float));
+      index_buf = (int32_t *) malloc ((size_t) num_threads * width * sizeof (int32_t));
+
+      if (shade_buf == NULL || index_buf == NULL) status = RENDER_MEMORY_ERROR;
+    }
+
+  if (pool == NULL)
+    {
+      status = RENDER_MEMORY_ERROR;
+    }
+  else
+    {
+      for (int32_t i = 0 ; i < pool_size && status == RENDER_SUCCESS ; i++)
+        {
+          pool[i].rows_buf = (float *) malloc ((size_t) (band_rows + 1) * width * sizeof (float));
+          if (pool[i].rows_buf == NULL) status = RENDER_MEMORY_ERROR;
+
+          if (!options->grey)
+            {
+              pool[i].pixels = (uint8_t *) malloc ((size_t) band_rows * width * bands);
+              if (pool[i].pixels == NULL) status = RENDER_MEMORY_ERROR;
+            }
+
+          free_queue.push (&pool[i]);
+        }
+    }
+
+  if (status != RENDER_SUCCESS) status = setError (status, QObject::tr ("Unable to allocate row buffers : ") + QString (strerror (errno)));
+
+
+  if (status == RENDER_SUCCESS && num_overviews)
+    {
+      overview = new overviewThread[num_overviews];
+
+      for (int32_t i = 0 ; i < num_overviews ; i++)
+        {
+          GDALRasterBand *ov_band[4];
+
+          for (int32_t b = 0 ; b < bands ; b++) ov_band[b] = bd[b]->GetOverview (i);
+
+          if (overview[i].setup (ov_band, bands, options->grey, overviewAverage (), overview_factor[i], width, height, null_value,
+                                 band_rows))
+            {
+              status = setError (RENDER_MEMORY_ERROR, QObject::tr ("Unable to allocate overview buffers : ") + QString (strerror (errno)));
+              break;
+            }
+        }
+    }
+
+
+  if (status == RENDER_SUCCESS)
+    {
+      stageStart (RENDER_IMAGE_STAGE, height);
+
+
+      //  Start the pipeline.
+
+      workers = new blockRenderer[num_threads];
+
+      for (int32_t t = 0 ; t < num_threads ; t++)
+        {
+          float *shade = NULL;
+          int32_t *index = NULL;
+
+          if (!options->grey)
+            {
+              shade = &shade_buf[(size_t) t * width];
+              index = &index_buf[(size_t) t * width];
+            }
+
+          workers[t].setup (this, &render_queue, &write_queue, shade, index);
+          workers[t].start ();
+        }
+
+      read_thread.setup (this, &free_queue, &render_queue, height, band_rows, num_threads);
+      read_thread.start ();
+
+
+      //  Write the blocks in order.  They can finish rendering out of order so we hold on to the early ones.
+
+      while (next_seq < num_blocks)
+        {
+          RENDER_BLOCK *block;
+
+          while (!pending.contains (next_seq))
+            {
+              block = write_queue.pop ();
+              pending.insert (block->seq, block);
+            }
+
+          block = pending.take (next_seq);
+
+
+          //  Start the overview levels on the block, write the block, and then write whatever overview rows got
+          //  finished.
+
+          for (int32_t i = 0 ; i < num_overviews ; i++)
+            {
+              overview[i].setChunk (block->k_start, block->rows, &block->rows_buf[width], block->pixels);
+              overview[i].start ();
+            }
+
+          status = writeRows (block->k_start, block->rows, &block->rows_buf[width], block->pixels);
+
+          for (int32_t i = 0 ; i < num_overviews ; i++) overview[i].wait ();
+
+          for (int32_t i = 0 ; i < num_overviews && status == RENDER_SUCCESS ; i++)
+            {
+              if (overview[i].flush () == CE_Failure)
+                status = setError (RENDER_WRITE_ERROR, QString (QObject::tr ("Failed a TIFF write - overview level %1")).arg
+                                   (overview_factor[i]));
+            }
+
+          if (status != RENDER_SUCCESS) break;
+
+
+          stageProgress (RENDER_IMAGE_STAGE, block->k_start + block->rows);
+
+          free_queue.push (block);
+          next_seq++;
+        }
+
+
+      //  If something went wrong, closing the queues stops the reader and the workers wherever they are.
+
+      if (status != RENDER_SUCCESS)
+        {
+          free_queue.close ();
+          render_queue.close ();
+          write_queue.close ();
+        }
+
+      read_thread.wait ();
+      for (int32_t t = 0 ; t < num_threads ; t++) workers[t].wait ();
+    }
+
+
+  if (workers) delete[] workers;
+  if (overview) delete[] overview;
+
+  if (pool)
+    {
+      for (int32_t i = 0 ; i < pool_size ; i++)
+        {
+          if (pool[i].rows_buf) free (pool[i].rows_buf);
+          if (pool[i].pixels) free (pool[i].pixels);
+        }
+      free (pool);
+    }
+
+  freeRender ();
+
+
+  //  Closing the dataset flushes it to disk.
+
+  delete df;
+  df = NULL;
+
+
+  if (status == RENDER_SUCCESS)
+    {
+      message (QString (QObject::tr ("Created TIFF file %1")).arg (name));
+      message (QString (QObject::tr ("%1 rows by %2 columns")).arg (height).arg (width));
+      if (num_overviews) message (QString (QObject::tr ("%1 overview levels")).arg (num_overviews));
+    }
+
+
+  return (status);
+}
+
+
+
+//!  GDAL progress callback for renderCog.  Most of the time is spent rendering the source so we just scale it.
+
+static int CPL_STDCALL cogProgress (double complete, const char *msg __attribute__ ((unused)), void *data)
+{
+  chrtrRenderEngine *engine = (chrtrRenderEngine *) data;
+
+  engine->reportProgress (RENDER_IMAGE_STAGE, NINT (complete * engine->rows ()));
+
+  return (TRUE);
+}
+
+
+
+/*!
+  Write a Cloud Optimized GeoTIFF.  The COG layout (all of the IFDs at the front, the overviews before the full
+  resolution image, and the ghost area metadata) can only be made by GDAL's COG driver and the COG driver only
+  does CreateCopy.  Instead of writing a normal GeoTIFF and translating it we hand the driver a renderDataset,
+  a virtual dataset whose blocks are rendered (by renderChunk) when the driver reads them.  The output file is
+  then written in one pass.  The driver reads the source twice, once to compute the overviews (into a small
+  temporary file) and once for the full resolution image, so the image is shaded twice.
+*/
+
+int32_t chrtrRenderEngine::renderCog ()
+{
+  int32_t             status;
+  GDALDriver          *cog;
+  char                **papszOptions = NULL;
+
+
+  if ((status = allocRender ()) != RENDER_SUCCESS)
+    {
+      freeRender ();
+      return (status);
+    }
+
+
+  cog = GetGDALDriverManager ()->GetDriverByName ("COG");
+
+  renderDataset *src = new renderDataset (this, width, height, bands, options->grey, chunk_rows, transform, wkt_string, null_value);
+
+
+  setCompression (&papszOptions);
+  papszOptions = CSLSetNameValue (papszOptions, "BLOCKSIZE", QString::number (options->tile_width).toLatin1 ());
+  papszOptions = CSLSetNameValue (papszOptions, "RESAMPLING", overviewAverage () ? "AVERAGE" : "NEAREST");
+  papszOptions = CSLSetNameValue (papszOptions, "OVERVIEWS", options->overviews ? "AUTO" : "NONE");
+  setCompressThreads (&papszOptions);
+  setBigTiff (&papszOptions);
+
+  stageStart (RENDER_IMAGE_STAGE, height);
+
+  GDALDataset *dst = cog->CreateCopy (name, src, FALSE, papszOptions, cogProgress, this);
+
+  CSLDestroy (papszOptions);
+
+
+  if (dst == NULL)
+    {
+      status = setError (RENDER_WRITE_ERROR, QString (QObject::tr ("Unable to write Cloud Optimized GeoTIFF %1 : %2")).arg
+                         (name).arg (CPLGetLastErrorMsg ()));
+    }
+  else
+    {
+      delete dst;
+    }
+
+  delete src;
+  freeRender ();
+
+
+  if (status == RENDER_SUCCESS)
+    {
+      message (QString (QObject::tr ("Created Cloud Optimized TIFF file %1")).arg (name));
+      message (QString (QObject::tr ("%1 rows by %2 columns")).arg (height).arg (width));
+    }
+
+
+  return (status);
+}
+
+
+
+//!  Generate the contour file from the grid array (see scribe.cpp).
+
+int32_t chrtrRenderEngine::contour ()
+{
+  int64_t scribe (int32_t, int32_t, float, float, float, float, float *, float, char *, OPTIONS *, double, double);
+
+
+  stageStart (RENDER_CONTOUR_STAGE, 0);
+
+  int64_t num_contours = scribe (width, height, mbr.min_x, mbr.min_y, min_z, max_z, ar, null_value, name, options, x_cell_degrees, y_cell_degrees);
+
+  stageProgress (RENDER_CONTOUR_STAGE, 1);
+
+
+  if (num_contours < 0) return (setError (RENDER_CONTOUR_ERROR, QObject::tr ("Unable to create the contour file")));
+
+
+  //  The old contouring package counted 1000 point segments, scribe counts whole lines.
+
+  message (QString (QObject::tr ("Generated %1 contour lines")).arg ((qlonglong) num_contours));
+
+
+  return (RENDER_SUCCESS);
+}
+
+
+
+//!  Close the input and output files and free the grid array.  Safe to call more than once.
+
+void chrtrRenderEngine::close ()
+{
+  if (df)
+    {
+      delete df;
+      df = NULL;
+    }
+
+
+  reader.close ();
+
+  mask.clear ();
+
+  index.clear ();
+
+
+  //  A cached grid belongs to the cache.
+
+  cache.discard ();
+
+  if (cache.mapped ())
+    {
+      cache.close ();
+      ar = NULL;
+    }
+  else if (ar)
+    {
+      free (ar);
+      ar = NULL;
+    }
+}
@@ -0,0 +1,428 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef CHRTRRENDERENGINE_H
+#define CHRTRRENDERENGINE_H
+
+#include "chrtrGeotiffDef.hpp"
+#include "chrtrReader.hpp"
+#include "areaMask.hpp"
+#include "gridCache.hpp"
+#include "statsIndex.hpp"
+
+
+//  Error codes returned by the chrtrRenderEngine stages (see chrtrRenderEngine::errorString).
+
+#define         RENDER_SUCCESS                  0
+#define         RENDER_CHRTR_OPEN_ERROR         -1
+#define         RENDER_AREA_FILE_ERROR          -2
+#define         RENDER_AREA_OUTSIDE_ERROR       -3
+#define         RENDER_MEMORY_ERROR             -4
+#define         RENDER_GDAL_DRIVER_ERROR        -5
+#define         RENDER_GDAL_CREATE_ERROR        -6
+#define         RENDER_WRITE_ERROR              -7
+#define         RENDER_CONTOUR_ERROR            -8
+
+
+//  Rows per thread in each chunk of the render stage and the most threads we'll use.
+
+#define         RENDER_BAND_ROWS                64
+#define         MAX_RENDER_THREADS              64
+
+
+//  Number of blocks per render worker in the render pipeline pool (how far the reader can get ahead).
+
+#define         RENDER_QUEUE_DEPTH              2
+
+
+//  Estimated (uncompressed) output size, in bytes, above which we write a BigTIFF.
+
+#define         BIGTIFF_THRESHOLD               4.0e9
+
+
+//  Most overview levels we'll build and the size (in pixels) at which we stop adding levels.
+
+#define         MAX_OVERVIEWS                   16
+#define         OVERVIEW_MIN_SIZE               256
+
+
+//  Stages reported through renderProgress.
+
+#define         RENDER_LOAD_STAGE               0
+#define         RENDER_IMAGE_STAGE              1
+#define         RENDER_CONTOUR_STAGE            2
+
+
+/*!
+  Progress callback interface for chrtrRenderEngine.  The wizard implements this with the progress bars and
+  checkList on the run page (runPage.cpp), batch mode implements it with stderr (batch.cpp).  The engine itself
+  never touches a widget.
+*/
+
+class renderProgress
+{
+public:
+
+  virtual ~renderProgress () {};
+
+
+  //!  Called at the start of a stage with the number of steps (0 means unknown).
+
+  virtual void stageStart (int32_t stage, int32_t steps) = 0;
+
+
+  //!  Called as each step of a stage completes.
+
+  virtual void stageProgress (int32_t stage, int32_t step) = 0;
+
+
+  //!  Status message (e.g. "Created TIFF file ...").
+
+  virtual void message (QString string) = 0;
+};
+
+
+
+class shadeThread;
+
+
+
+//!  One block of rows moving through the render pipeline (see chrtrRenderEngine::render).
+
+typedef struct
+{
+  int32_t       seq;                        //  Block number (0 is the northernmost block)
+  int32_t       k_start;                    //  Output row (0 is north) of the first row
+  int32_t       rows;                       //  Number of rows
+  float         *rows_buf;                  //  rows + 1 rows of Z, row 0 is the sunshade halo
+  uint8_t       *pixels;                    //  Packed RGB(A) output (not used for grey scale)
+} RENDER_BLOCK;
+
+
+
+/*!
+  GUI free CHRTR/CHRTR2 to GeoTIFF conversion engine.  This used to be one big slot (slotCustomButtonClicked).
+  The stages are, in order:
+
+  - open - open the CHRTR/CHRTR2 file and compute the output window, and the polygon mask, from the optional
+    area file
+  - load - read the window into the grid array (ar), converting units and depth/elevation, or map it from the
+    grid cache (see gridCache) if it's been loaded before
+  - stats - compute the min/max and color ranges from the grid array (or from the statistics index, see statsIndex)
+  - createOutput - create the GeoTIFF with GDAL (or, for a Cloud Optimized GeoTIFF, just check for the COG driver)
+  - render - a pipeline that reads blocks of rows on one thread (fetchBlock), sunshades and colors them on
+    options->num_threads threads (shadeBlock), and writes them in order (writeRows).  If we're building overviews each overview level is computed from the same chunk on its own
+    thread (overviewThread).  Cloud Optimized GeoTIFFs are written by the COG driver from a renderDataset whose
+    blocks are rendered (renderChunk) as the driver reads them (renderCog).
+  - contour - generate the optional ESRI contour file (scribe.cpp)
+
+  If we're streaming (options->stream set and no contours) the grid array is never allocated.  The stats stage
+  reads every row once to get the min/max and the render stage reads the rows again, north to south, a chunk at
+  a time.  Peak memory is then proportional to the width of the grid instead of the size of the grid.  If the
+  grid array can't be allocated and we don't need it for contours we switch to streaming automatically.
+
+  Each stage returns RENDER_SUCCESS or one of the RENDER_*_ERROR codes.  On error, errorString describes what
+  went wrong.  run does all of the stages in order and cleans up no matter what happens so one bad file won't
+  kill a batch run.
+*/
+
+class chrtrRenderEngine
+{
+public:
+
+  chrtrRenderEngine (OPTIONS *op = NULL, renderProgress *prog = NULL);
+  ~chrtrRenderEngine ();
+
+  int32_t run (char *chrtr_name, char *output_name, char *area_name, uint8_t contour_flag);
+
+  int32_t open (char *chrtr_name, char *area_name);
+  int32_t load ();
+  int32_t stats ();
+  int32_t createOutput (char *output_name);
+  int32_t render ();
+  int32_t contour ();
+  void close ();
+
+  void shadeRow (float *next_row, float *current_row, uint8_t *pixels, float *shade, int32_t *index);
+  void shadeRows (int32_t count, float *rows_buf, uint8_t *pixels, float *shade, int32_t *index);
+  void renderChunk (int32_t k_start, int32_t rows);
+  void fetchBlock (RENDER_BLOCK *block);
+  void shadeBlock (RENDER_BLOCK *block, float *shade, int32_t *index);
+  void reportProgress (int32_t stage, int32_t step) {stageProgress (stage, step);};
+
+  static const char *codecName (int32_t codec);
+
+  QString errorString () {return (error_string);};
+  int32_t rows () {return (height);};
+  int32_t cols () {return (width);};
+  float minZ () {return (min_z);};
+  float maxZ () {return (max_z);};
+  uint8_t isStreaming () {return (streaming);};
+  int32_t chunkRows () {return (chunk_rows);};
+  uint8_t *chunkPixels () {return (pixels);};
+  float *chunkGrey () {return (&rows_buf[width]);};
+
+
+protected:
+
+  int32_t setError (int32_t err, QString string);
+  int32_t indexStats ();
+  void setColors ();
+  void setCompression (char ***papszOptions);
+  void setCompressThreads (char ***papszOptions);
+  void setBigTiff (char ***papszOptions);
+  uint8_t overviewAverage ();
+  float convertZ (float z_value);
+  void loadRow (int32_t row, float *dest);
+  void fetchRow (int32_t k, float *dest);
+  int32_t writeRows (int32_t k_start, int32_t rows, float *grey_rows, uint8_t *pixels);
+  void setChunking ();
+  int32_t allocRender ();
+  void freeRender ();
+  int32_t renderCog ();
+  void stageStart (int32_t stage, int32_t steps);
+  void stageProgress (int32_t stage, int32_t step);
+  void message (QString string);
+
+
+  OPTIONS          *options;
+
+  renderProgress   *progress;
+
+  QString          error_string;
+
+  chrtrReader      reader;
+
+  areaMask         mask;                    //!<  Area polygons rasterized over the output window (see loadRow)
+
+  gridCache        cache;                   //!<  Saved copy of the loaded grid (see load and stats)
+
+  statsIndex       index;                   //!<  Block statistics for the CHRTR file (see indexStats)
+
+  int32_t          width, height, x_start, y_start;
+
+  NV_F64_XYMBR     mbr;
+
+  double           x_cell_degrees, y_cell_degrees, x_cell_size, y_cell_size, transform[6];
+
+  float            *ar, min_z, max_z, null_value, range[2];
+
+  uint32_t         color_lut[NUMSHADES * (NUMHUES + 1)]; //!<  Packed RGBA copy of options->color_array (see setColors)
+
+  uint8_t          cross_zero, streaming, contour_requested;
+
+  GDALDataset      *df;
+
+  GDALRasterBand   *bd[4];
+
+  int32_t          bands, num_overviews, overview_factor[MAX_OVERVIEWS];
+
+
+  //  Render stage chunk buffers (see allocRender).
+
+  float            *rows_buf, *shade_buf;
+
+  uint8_t          *pixels;
+
+  int32_t          *index_buf, num_threads, band_rows, chunk_rows;
+
+  shadeThread      *thread;
+
+  char             name[512];
+};
+
+
+
+//!  Worker thread that shades one band of rows for chrtrRenderEngine::render.
+
+class shadeThread : public QThread
+{
+public:
+
+  shadeThread ();
+
+  void setup (chrtrRenderEngine *eng, int32_t rows, float *buf, uint8_t *pix, float *shd, int32_t *ndx);
+
+
+protected:
+
+  void run ();
+
+
+  chrtrRenderEngine *engine;
+
+  int32_t          count;
+
+  float            *rows_buf, *shade;
+
+  int32_t          *index;
+
+  uint8_t          *pixels;
+};
+
+
+
+/*!
+  Worker thread that builds one overview level of the GeoTIFF from the full resolution rows as they're rendered.
+  Each output pixel is either the center pixel (nearest neighbor) or the average of a factor by factor block of full
+  resolution pixels.  When averaging, empty cells (null for grey scale, alpha 0 for transparent color) are left out
+  and a block with no data is empty.  For 3 band color the empty cells are black so they get averaged in, which is
+  why nearest neighbor is the default for color.  The thread only computes
+  rows (run) since a GDAL dataset can't be written from more than one thread at a time.  The engine writes the
+  completed rows (flush) after it has written the chunk.
+*/
+
+class overviewThread : public QThread
+{
+public:
+
+  overviewThread ();
+  ~overviewThread ();
+
+  int32_t setup (GDALRasterBand **band, int32_t num_bands, uint8_t grey, uint8_t avg, int32_t ov_factor,
+                 int32_t full_width, int32_t full_height, float null, int32_t max_rows);
+  void setChunk (int32_t start, int32_t rows, float *grey_rows, uint8_t *pix);
+  CPLErr flush ();
+
+
+protected:
+
+  void run ();
+  void addRow (float *grey_row, uint8_t *pixel_row);
+  void finishRow ();
+
+
+  GDALRasterBand   *ov[4];
+
+  int32_t          bands, factor, width, height, ov_width, acc_rows, out_start, out_rows, k_start, count;
+
+  uint8_t          is_grey, average;
+
+  float            null_value, *grey_in, *grey_out;
+
+  uint8_t          *pixels_in, *pixels_out;
+
+  double           *sum;
+
+  uint32_t         *hits;
+};
+
+
+
+/*!
+  Queue of blocks between the stages of the render pipeline.  The queue itself isn't bounded, the pool of blocks
+  is, so a stage that gets ahead ends up waiting on the free block queue.  Closing the queue (on an error) makes
+  every pop return NULL.
+*/
+
+class blockQueue
+{
+public:
+
+  blockQueue ();
+
+  void push (RENDER_BLOCK *block);
+  RENDER_BLOCK *pop ();
+  void close ();
+
+
+protected:
+
+  QMutex           mutex;
+
+  QWaitCondition   cond;
+
+  QQueue<RENDER_BLOCK *> queue;
+
+  uint8_t          closed;
+};
+
+
+
+//!  Render pipeline reader thread.  Fills free blocks with rows, north to south, and queues them for rendering.
+
+class blockReader : public QThread
+{
+public:
+
+  blockReader ();
+
+  void setup (chrtrRenderEngine *eng, blockQueue *free_blocks, blockQueue *render_blocks, int32_t rows, int32_t block_rows,
+              int32_t workers);
+
+
+protected:
+
+  void run ();
+
+
+  chrtrRenderEngine *engine;
+
+  blockQueue       *free_queue, *render_queue;
+
+  int32_t          height, band_rows, num_workers;
+};
+
+
+
+//!  Render pipeline worker thread.  Sunshades and colors blocks until it gets a NULL block.
+
+class blockRenderer : public QThread
+{
+public:
+
+  blockRenderer ();
+
+  void setup (chrtrRenderEngine *eng, blockQueue *in, blockQueue *out, float *shd, int32_t *ndx);
+
+
+protected:
+
+  void run ();
+
+
+  chrtrRenderEngine *engine;
+
+  blockQueue       *in_queue, *out_queue;
+
+  float            *shade;
+
+  int32_t          *index;
+};
+
+#endif
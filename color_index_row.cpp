@@ -0,0 +1,259 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "chrtrGeotiffDef.hpp"
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define COLOR_INDEX_ROW_X86
+#include <immintrin.h>
+#endif
+
+
+//  The scalar and SIMD versions must do the same single precision operations so a cell gets the same index no
+//  matter which version (or CPU) did it.  Never fuse a multiply and an add.  The build also uses -ffp-contract=off.
+
+#if defined (__GNUC__) && !defined (__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+
+//  Constants shared by the scalar and SIMD versions of color_index_row.
+
+typedef struct
+{
+  float         min_z;
+  float         scale[2];           //  NUMHUES / range[0] and NUMHUES / range[1]
+  float         null_value;
+  uint8_t       cross_zero;
+} INDEX_CONST;
+
+
+
+static inline int32_t index_one (float z, float shade, INDEX_CONST *sc)
+{
+  int32_t c_index;
+
+
+  if (z >= sc->null_value)
+    {
+      c_index = -2;
+    }
+  else if (sc->cross_zero && z >= 0.0f)
+    {
+      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf (z) * sc->scale[1])) * NUMSHADES;
+    }
+  else
+    {
+      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf (z - sc->min_z) * sc->scale[0])) * NUMSHADES;
+    }
+
+
+  //  Shade offset, NINT (NUMSHADES * shade + 0.5) rounding half away from zero like NINT, but in single precision
+  //  exactly the way the SIMD versions do it.
+
+  float offset = (float) NUMSHADES * shade + 0.5f;
+
+  offset += copysignf (0.5f, offset);
+
+  c_index -= (int32_t) offset;
+
+  return (c_index);
+}
+
+
+
+#ifdef COLOR_INDEX_ROW_X86
+
+//  Eight cells at a time.  Returns the index of the first cell that wasn't done.
+
+__attribute__ ((target ("avx2")))
+static int32_t index_avx2 (float *row, float *shade, int32_t width, INDEX_CONST *sc, int32_t *c_index)
+{
+  int32_t j;
+  __m256 abs_mask = _mm256_castsi256_ps (_mm256_set1_epi32 (0x7fffffff)), min_z = _mm256_set1_ps (sc->min_z);
+  __m256 scale0 = _mm256_set1_ps (sc->scale[0]), scale1 = _mm256_set1_ps (sc->scale[1]);
+  __m256 null = _mm256_set1_ps (sc->null_value), zero = _mm256_setzero_ps ();
+  __m256 cross = _mm256_castsi256_ps (_mm256_set1_epi32 (sc->cross_zero ? -1 : 0));
+  __m256 num_shades = _mm256_set1_ps ((float) NUMSHADES), half = _mm256_set1_ps (0.5f);
+  __m256i num_hues = _mm256_set1_epi32 (NUMHUES), shades = _mm256_set1_epi32 (NUMSHADES);
+  __m256i null_index = _mm256_set1_epi32 (-2);
+
+
+  for (j = 0 ; j + 8 <= width ; j += 8)
+    {
+      __m256 z = _mm256_loadu_ps (&row[j]);
+
+
+      //  Hue position for both cases, then pick the positive side of zero where we're crossing zero.
+
+      __m256 below = _mm256_mul_ps (_mm256_and_ps (_mm256_sub_ps (z, min_z), abs_mask), scale0);
+      __m256 above = _mm256_mul_ps (_mm256_and_ps (z, abs_mask), scale1);
+      __m256 use_above = _mm256_and_ps (cross, _mm256_cmp_ps (z, zero, _CMP_GE_OQ));
+      __m256 hue = _mm256_blendv_ps (below, above, use_above);
+
+      __m256i index = _mm256_mullo_epi32 (_mm256_sub_epi32 (num_hues, _mm256_cvttps_epi32 (hue)), shades);
+
+      index = _mm256_castps_si256 (_mm256_blendv_ps (_mm256_castsi256_ps (index), _mm256_castsi256_ps (null_index),
+                                                     _mm256_cmp_ps (z, null, _CMP_GE_OQ)));
+
+
+      //  Shade offset, NINT (NUMSHADES * shade + 0.5) rounding half away from zero like NINT.
+
+      __m256 offset = _mm256_add_ps (_mm256_mul_ps (num_shades, _mm256_loadu_ps (&shade[j])), half);
+      __m256 sign = _mm256_andnot_ps (abs_mask, offset);
+
+      offset = _mm256_add_ps (offset, _mm256_or_ps (half, sign));
+
+      index = _mm256_sub_epi32 (index, _mm256_cvttps_epi32 (offset));
+
+      _mm256_storeu_si256 ((__m256i *) &c_index[j], index);
+    }
+
+  return (j);
+}
+
+
+
+//  Four cells at a time.  Returns the index of the first cell that wasn't done.
+
+__attribute__ ((target ("sse4.1")))
+static int32_t index_sse4 (float *row, float *shade, int32_t width, INDEX_CONST *sc, int32_t *c_index)
+{
+  int32_t j;
+  __m128 abs_mask = _mm_castsi128_ps (_mm_set1_epi32 (0x7fffffff)), min_z = _mm_set1_ps (sc->min_z);
+  __m128 scale0 = _mm_set1_ps (sc->scale[0]), scale1 = _mm_set1_ps (sc->scale[1]);
+  __m128 null = _mm_set1_ps (sc->null_value), zero = _mm_setzero_ps ();
+  __m128 cross = _mm_castsi128_ps (_mm_set1_epi32 (sc->cross_zero ? -1 : 0));
+  __m128 num_shades = _mm_set1_ps ((float) NUMSHADES), half = _mm_set1_ps (0.5f);
+  __m128i num_hues = _mm_set1_epi32 (NUMHUES), shades = _mm_set1_epi32 (NUMSHADES);
+  __m128i null_index = _mm_set1_epi32 (-2);
+
+
+  for (j = 0 ; j + 4 <= width ; j += 4)
+    {
+      __m128 z = _mm_loadu_ps (&row[j]);
+
+      __m128 below = _mm_mul_ps (_mm_and_ps (_mm_sub_ps (z, min_z), abs_mask), scale0);
+      __m128 above = _mm_mul_ps (_mm_and_ps (z, abs_mask), scale1);
+      __m128 use_above = _mm_and_ps (cross, _mm_cmpge_ps (z, zero));
+      __m128 hue = _mm_blendv_ps (below, above, use_above);
+
+      __m128i index = _mm_mullo_epi32 (_mm_sub_epi32 (num_hues, _mm_cvttps_epi32 (hue)), shades);
+
+      index = _mm_castps_si128 (_mm_blendv_ps (_mm_castsi128_ps (index), _mm_castsi128_ps (null_index),
+                                               _mm_cmpge_ps (z, null)));
+
+      __m128 offset = _mm_add_ps (_mm_mul_ps (num_shades, _mm_loadu_ps (&shade[j])), half);
+      __m128 sign = _mm_andnot_ps (abs_mask, offset);
+
+      offset = _mm_add_ps (offset, _mm_or_ps (half, sign));
+
+      index = _mm_sub_epi32 (index, _mm_cvttps_epi32 (offset));
+
+      _mm_storeu_si128 ((__m128i *) &c_index[j], index);
+    }
+
+  return (j);
+}
+
+#endif
+
+
+
+/***************************************************************************\
+*                                                                           *
+*   Module Name:        color_index_row                                     *
+*                                                                           *
+*   Programmer(s):      PFM Software                                        *
+*                                                                           *
+*   Date Written:       October 2026                                        *
+*                                                                           *
+*   Purpose:            Convert a row of Z values and shade factors (from   *
+*                       sunshade_row) to indices into the NUMSHADES by      *
+*                       (NUMHUES + 1) color table in one pass.  Uses AVX2   *
+*                       or SSE4.1 (picked at run time) with a scalar tail.  *
+*                                                                           *
+*   Arguments:          row         -   Z values                            *
+*                       shade       -   shade factors                       *
+*                       width       -   number of cells in the row          *
+*                       min_z       -   minimum Z                           *
+*                       range       -   color ranges (range[1] is only      *
+*                                       used when crossing zero)            *
+*                       cross_zero  -   NVTrue to restart the colors at 0   *
+*                       null_value  -   values >= this are null             *
+*                       c_index     -   color indices (width values)        *
+*                                                                           *
+*   Return Value:       None                                                *
+*                                                                           *
+*   Caveats:            Null cells get a negative index.  Since we          *
+*                       multiply by NUMHUES / range instead of dividing     *
+*                       by range a value that lands exactly on a hue        *
+*                       boundary may round to the neighboring hue.          *
+*                                                                           *
+\***************************************************************************/
+
+void color_index_row (float *row, float *shade, int32_t width, float min_z, float *range, uint8_t cross_zero,
+                      float null_value, int32_t *c_index)
+{
+  INDEX_CONST         sc;
+  int32_t             j = 0;
+
+
+  sc.min_z = min_z;
+  sc.scale[0] = (range[0] != 0.0) ? (float) NUMHUES / range[0] : 0.0f;
+  sc.scale[1] = (range[1] != 0.0) ? (float) NUMHUES / range[1] : 0.0f;
+  sc.null_value = null_value;
+  sc.cross_zero = cross_zero;
+
+
+#ifdef COLOR_INDEX_ROW_X86
+
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      j = index_avx2 (row, shade, width, &sc, c_index);
+    }
+  else if (__builtin_cpu_supports ("sse4.1"))
+    {
+      j = index_sse4 (row, shade, width, &sc, c_index);
+    }
+
+#endif
+
+
+  for ( ; j < width ; j++) c_index[j] = index_one (row[j], shade[j], &sc);
+}
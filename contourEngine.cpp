@@ -0,0 +1,1035 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "contourEngine.hpp"
+
+#include <algorithm>
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define CONTOUR_ENGINE_X86
+#include <immintrin.h>
+#endif
+
+
+//  One end of a contour piece (piece_end is 2 * piece index, plus one for the last point) and its edge key.
+
+typedef struct
+{
+  uint64_t         key;
+  int64_t          piece_end;
+} CONTOUR_END;
+
+
+//  Orders contour piece ends by key.
+
+static bool end_less (const CONTOUR_END &a, const CONTOUR_END &b)
+{
+  return (a.key < b.key);
+}
+
+
+//  Position of a finished line in the standard order (see contourEngine::finish).
+
+typedef struct
+{
+  uint64_t         key;
+  int64_t          line, offset;
+  uint8_t          reversed;
+} CONTOUR_ORDER;
+
+
+//  Orders the finished lines of a level by first key (no two lines of a level cross the same edge).
+
+static bool order_less (const CONTOUR_ORDER &a, const CONTOUR_ORDER &b)
+{
+  return (a.key < b.key);
+}
+
+
+/*
+  Grid edges crossed by the contour for each marching squares case.  The case is the sum of 1 (lower left),
+  2 (lower right), 4 (upper right), and 8 (upper left) for the corners that are at or above the level.  Edge 0 is
+  the bottom, 1 is the right, 2 is the top, and 3 is the left side of the cell.  Cases 5 and 10 are saddles and
+  are handled separately.
+*/
+
+static const int8_t cell_edges[16][2] = {{-1, -1}, {3, 0}, {0, 1}, {3, 1}, {1, 2}, {-1, -1}, {0, 2}, {3, 2},
+                                          {2, 3}, {0, 2}, {-1, -1}, {1, 2}, {3, 1}, {0, 1}, {3, 0}, {-1, -1}};
+
+
+
+contourSet::contourSet ()
+{
+  start.push_back (0);
+}
+
+
+
+void contourSet::clear ()
+{
+  x.clear ();
+  y.clear ();
+  key.clear ();
+  start.clear ();
+  start.push_back (0);
+  level.clear ();
+  closed.clear ();
+}
+
+
+
+void contourSet::addPoint (float px, float py, uint64_t k)
+{
+  x.push_back (px);
+  y.push_back (py);
+  key.push_back (k);
+}
+
+
+
+//!  Finish the line made up of the points added since the last endLine.
+
+void contourSet::endLine (float lvl, uint8_t is_closed)
+{
+  start.push_back ((int64_t) x.size ());
+  level.push_back (lvl);
+  closed.push_back (is_closed);
+}
+
+
+
+contourEngine::contourEngine ()
+{
+  ar = NULL;
+  null_value = level = 0.0;
+  width = height = tiles_x = tiles_y = next_tile = 0;
+  current_level = -1;
+}
+
+
+
+//!  Set the contour levels to the multiples of interval between min_z and max_z.
+
+void contourEngine::setLevels (float min_z, float max_z, float interval)
+{
+  levels.clear ();
+
+  if (interval <= 0.0) return;
+
+
+  int32_t first = (int32_t) ceil (min_z / interval);
+  int32_t last = (int32_t) floor (max_z / interval);
+
+  for (int32_t k = first ; k <= last ; k++) levels.append ((float) k * interval);
+}
+
+
+
+//!  Get the next tile to work on (or -1 if there are none left).  When tracing, tiles the level misses are skipped.
+
+int32_t contourEngine::nextTile ()
+{
+  QMutexLocker lock (&mutex);
+
+  while (next_tile < tiles_x * tiles_y)
+    {
+      int32_t tile = next_tile++;
+
+      if (current_level < 0 || (level > tile_min[tile] && level <= tile_max[tile])) return (tile);
+    }
+
+  return (-1);
+}
+
+
+
+//!  Grid rows and columns of the points in tile "tile" (the tiles share their boundary points).
+
+static void tile_extent (int32_t tile, int32_t tiles_x, int32_t width, int32_t height, int32_t *row_start,
+                         int32_t *col_start, int32_t *rows, int32_t *cols)
+{
+  *row_start = (tile / tiles_x) * CONTOUR_TILE_SIZE;
+  *col_start = (tile % tiles_x) * CONTOUR_TILE_SIZE;
+  *rows = qMin (*row_start + CONTOUR_TILE_SIZE, height - 1) - *row_start + 1;
+  *cols = qMin (*col_start + CONTOUR_TILE_SIZE, width - 1) - *col_start + 1;
+}
+
+
+
+//!  Find the min and max of the valid points of tile "tile" (null_value and -null_value if there are none).
+
+void contourEngine::tileRange (int32_t tile)
+{
+  int32_t row_start, col_start, rows, cols;
+  float min_z = null_value, max_z = -null_value;
+
+
+  tile_extent (tile, tiles_x, width, height, &row_start, &col_start, &rows, &cols);
+
+  for (int32_t i = 0 ; i < rows ; i++)
+    {
+      float *row = &ar[(size_t) (row_start + i) * width + col_start];
+
+      for (int32_t j = 0 ; j < cols ; j++)
+        {
+          if (row[j] < null_value)
+            {
+              min_z = qMin (min_z, row[j]);
+              max_z = qMax (max_z, row[j]);
+            }
+        }
+    }
+
+  tile_min[tile] = min_z;
+  tile_max[tile] = max_z;
+}
+
+
+
+/*!
+  Compute the position and key of the point where the level crosses edge "edge" of the cell whose lower left
+  corner is grid point (row, col).  The crossing is always interpolated from the lower (or left) end of the
+  grid edge so both of the cells that share the edge get exactly the same point.
+*/
+
+static void edge_point (float *ar, int32_t width, int32_t row, int32_t col, int32_t edge, float level, float *x,
+                        float *y, uint64_t *key)
+{
+  int32_t r = row, c = col;
+  uint8_t vertical = NVFalse;
+
+  switch (edge)
+    {
+    case 1:
+      c++;
+      vertical = NVTrue;
+      break;
+
+    case 2:
+      r++;
+      break;
+
+    case 3:
+      vertical = NVTrue;
+      break;
+    }
+
+
+  size_t index = (size_t) r * width + c;
+  float a = ar[index], b = vertical ? ar[index + width] : ar[index + 1];
+  float t = (level - a) / (b - a);
+
+  if (vertical)
+    {
+      *x = (float) c;
+      *y = (float) r + t;
+    }
+  else
+    {
+      *x = (float) c + t;
+      *y = (float) r;
+    }
+
+  *key = (uint64_t) index * 2 + vertical;
+}
+
+
+
+//  Bit e (edge number) is set for the edges crossed by the contour in each marching squares case.
+
+static const uint8_t edge_crossed[16] = {0, 9, 3, 10, 6, 15, 5, 12, 12, 5, 15, 6, 10, 3, 9, 0};
+
+
+//  Row and column step to the cell on the other side of each edge and the number of that edge in that cell.
+
+static const int8_t cell_step[4][2] = {{-1, 0}, {0, 1}, {1, 0}, {0, -1}};
+static const int8_t opposite_edge[4] = {2, 3, 0, 1};
+
+
+/*
+  Working data for tracing one tile at one level.  Points and cells are numbered from the tile's lower left grid
+  point.  The bitmaps have a row of "words" 64 bit words for each row of points (or cells).  The visited bitmap has
+  a bit for each edge numbered the same way as the edge keys (2 * (row * cols + col), plus one for vertical).
+*/
+
+typedef struct
+{
+  float            *ar;                     //  Grid array
+  int32_t          width;                   //  Grid width
+  int32_t          row_start, col_start;    //  Grid row and column of the tile's lower left point
+  int32_t          rows, cols, words;       //  Points in the tile and 64 bit words per row of bits
+  float            level;
+  uint64_t         *above;                  //  Points at or above the level
+  uint64_t         *cell_ok;                //  Cells with four valid corners
+  uint64_t         *visited;                //  Edges already traced
+} CONTOUR_TILE;
+
+
+
+static inline uint8_t get_bit (uint64_t *bits, int64_t index)
+{
+  return ((bits[index >> 6] >> (index & 63)) & 1);
+}
+
+
+
+static inline void set_bit (uint64_t *bits, int64_t index)
+{
+  bits[index >> 6] |= (uint64_t) 1 << (index & 63);
+}
+
+
+
+//  Word w of a row of bits shifted down by one (bit j is bit j + 1 of the row).
+
+static inline uint64_t next_bits (uint64_t *bits, int32_t w, int32_t words)
+{
+  return ((bits[w] >> 1) | ((w + 1 < words) ? bits[w + 1] << 63 : 0));
+}
+
+
+
+static inline int32_t lowest_bit (uint64_t word)
+{
+#ifdef __GNUC__
+  return (__builtin_ctzll (word));
+#else
+  int32_t bit = 0;
+
+  while (!(word & 1))
+    {
+      word >>= 1;
+      bit++;
+    }
+
+  return (bit);
+#endif
+}
+
+
+
+//  Bit j of bits is set if row[j] >= value (count values, the bits past count in the last word are 0).
+
+#ifdef CONTOUR_ENGINE_X86
+
+__attribute__ ((target ("avx2")))
+static int32_t ge_bits_avx2 (float *row, int32_t count, float value, uint64_t *bits)
+{
+  int32_t j;
+  __m256 v = _mm256_set1_ps (value);
+
+  for (j = 0 ; j + 64 <= count ; j += 64)
+    {
+      uint64_t word = 0;
+
+      for (int32_t k = 0 ; k < 8 ; k++)
+        word |= (uint64_t) _mm256_movemask_ps (_mm256_cmp_ps (_mm256_loadu_ps (&row[j + k * 8]), v, _CMP_GE_OQ)) << (k * 8);
+
+      bits[j >> 6] = word;
+    }
+
+  return (j);
+}
+
+
+
+__attribute__ ((target ("sse2")))
+static int32_t ge_bits_sse2 (float *row, int32_t count, float value, uint64_t *bits)
+{
+  int32_t j;
+  __m128 v = _mm_set1_ps (value);
+
+  for (j = 0 ; j + 64 <= count ; j += 64)
+    {
+      uint64_t word = 0;
+
+      for (int32_t k = 0 ; k < 16 ; k++)
+        word |= (uint64_t) _mm_movemask_ps (_mm_cmpge_ps (_mm_loadu_ps (&row[j + k * 4]), v)) << (k * 4);
+
+      bits[j >> 6] = word;
+    }
+
+  return (j);
+}
+
+#endif
+
+
+
+static void ge_bits (float *row, int32_t count, float value, uint64_t *bits)
+{
+  int32_t j = 0;
+
+
+#ifdef CONTOUR_ENGINE_X86
+
+  if (__builtin_cpu_supports ("avx2"))
+    {
+      j = ge_bits_avx2 (row, count, value, bits);
+    }
+  else if (__builtin_cpu_supports ("sse2"))
+    {
+      j = ge_bits_sse2 (row, count, value, bits);
+    }
+
+#endif
+
+
+  if (j < count)
+    {
+      uint64_t word = 0;
+
+      for (int32_t k = j ; k < count ; k++) if (row[k] >= value) word |= (uint64_t) 1 << (k - j);
+
+      bits[j >> 6] = word;
+    }
+}
+
+
+
+//  Marching squares case of tile cell (i, j) (see cell_edges).
+
+static inline int32_t cell_type (CONTOUR_TILE *ct, int32_t i, int32_t j)
+{
+  int64_t lower = (int64_t) i * ct->words * 64 + j, upper = lower + ct->words * 64;
+
+  return (get_bit (ct->above, lower) | (get_bit (ct->above, lower + 1) << 1) | (get_bit (ct->above, upper + 1) << 2) |
+          (get_bit (ct->above, upper) << 3));
+}
+
+
+
+//  Whether tile cell (i, j) is in the tile and has four valid corners.
+
+static inline uint8_t cell_valid (CONTOUR_TILE *ct, int32_t i, int32_t j)
+{
+  if (i < 0 || j < 0 || i >= ct->rows - 1 || j >= ct->cols - 1) return (NVFalse);
+
+  return (get_bit (ct->cell_ok, (int64_t) i * ct->words * 64 + j));
+}
+
+
+
+//  Visited bitmap index of edge "edge" of tile cell (i, j).
+
+static inline int64_t edge_id (CONTOUR_TILE *ct, int32_t i, int32_t j, int32_t edge)
+{
+  switch (edge)
+    {
+    case 0:
+      return (((int64_t) i * ct->cols + j) * 2);
+
+    case 1:
+      return (((int64_t) i * ct->cols + j + 1) * 2 + 1);
+
+    case 2:
+      return (((int64_t) (i + 1) * ct->cols + j) * 2);
+    }
+
+  return (((int64_t) i * ct->cols + j) * 2 + 1);
+}
+
+
+
+//  The edge the contour leaves tile cell (i, j) by when it comes in by edge "entry".
+
+static inline int32_t exit_edge (CONTOUR_TILE *ct, int32_t i, int32_t j, int32_t cell_case, int32_t entry)
+{
+  if (cell_case == 5 || cell_case == 10)
+    {
+      //  Saddle.  The average of the corners decides whether the high corners are connected.
+
+      float *lower = &ct->ar[(size_t) (ct->row_start + i) * ct->width + ct->col_start + j], *upper = lower + ct->width;
+      uint8_t center_high = ((lower[0] + lower[1] + upper[1] + upper[0]) * 0.25f >= ct->level);
+
+      if ((cell_case == 5) == center_high) return (entry ^ 1);
+
+      return (3 - entry);
+    }
+
+
+  return ((cell_edges[cell_case][0] == entry) ? cell_edges[cell_case][1] : cell_edges[cell_case][0]);
+}
+
+
+
+/*
+  Trace a line that crosses edge "start" of tile cell (i, j) into that cell, from cell to cell, until it gets
+  back to the start edge (closed) or leaves the valid cells of the tile.  The line is appended to "out".
+*/
+
+static void trace_line (CONTOUR_TILE *ct, int32_t i, int32_t j, int32_t start, contourSet &out)
+{
+  int64_t start_id = edge_id (ct, i, j, start);
+  int32_t entry = start;
+  uint8_t closed = NVFalse;
+  float x, y;
+  uint64_t key;
+
+
+  set_bit (ct->visited, start_id);
+  edge_point (ct->ar, ct->width, ct->row_start + i, ct->col_start + j, start, ct->level, &x, &y, &key);
+  out.addPoint (x, y, key);
+
+  while (1)
+    {
+      int32_t edge = exit_edge (ct, i, j, cell_type (ct, i, j), entry);
+      int64_t id = edge_id (ct, i, j, edge);
+
+      if (id == start_id)
+        {
+          closed = NVTrue;
+          break;
+        }
+
+      set_bit (ct->visited, id);
+      edge_point (ct->ar, ct->width, ct->row_start + i, ct->col_start + j, edge, ct->level, &x, &y, &key);
+      out.addPoint (x, y, key);
+
+
+      i += cell_step[edge][0];
+      j += cell_step[edge][1];
+      entry = opposite_edge[edge];
+
+      if (!cell_valid (ct, i, j)) break;
+    }
+
+  out.endLine (ct->level, closed);
+}
+
+
+
+/*!
+  Trace the current level in one tile and append the lines (closed or ending on the tile boundary, the edge of
+  the grid, or null cells) to "out".
+
+  The grid points are classified a row at a time into bits (at or above the level) and a row that
+  is all above or all below the level (from the row min and max) is just filled.  Cells that might have a crossing
+  are found 64 at a time by comparing each row of bits with itself shifted by one column and with the next row.
+  Lines are traced from cell to cell, marking the crossed edges in a visited bitmap.  The lines that end on an
+  edge with no valid cell on the other side are traced first so that anything left afterward is a closed line.
+*/
+
+void contourEngine::traceTile (int32_t tile, contourSet &out)
+{
+  CONTOUR_TILE ct;
+
+  ct.ar = ar;
+  ct.width = width;
+  ct.level = level;
+  tile_extent (tile, tiles_x, width, height, &ct.row_start, &ct.col_start, &ct.rows, &ct.cols);
+  ct.words = (ct.cols + 63) / 64;
+
+
+  //  Valid (non-null) points, cells with four valid corners, and the min and max of each row of points.
+
+  QVector<uint64_t> valid (ct.rows * ct.words), cell_ok ((ct.rows - 1) * ct.words), above (ct.rows * ct.words);
+  QVector<uint64_t> visited ((2 * ct.rows * ct.cols + 63) / 64);
+  QVector<float> row_min (ct.rows), row_max (ct.rows);
+  QVector<uint8_t> row_state (ct.rows);
+  uint64_t tail_mask = (ct.cols & 63) ? ((uint64_t) 1 << (ct.cols & 63)) - 1 : ~(uint64_t) 0;
+
+  for (int32_t i = 0 ; i < ct.rows ; i++)
+    {
+      float *row = &ar[(size_t) (ct.row_start + i) * width + ct.col_start];
+      uint64_t *bits = &valid[i * ct.words];
+
+      ge_bits (row, ct.cols, null_value, bits);
+
+      for (int32_t w = 0 ; w < ct.words ; w++) bits[w] = ~bits[w];
+      bits[ct.words - 1] &= tail_mask;
+
+
+      row_min[i] = null_value;
+      row_max[i] = -null_value;
+
+      for (int32_t j = 0 ; j < ct.cols ; j++)
+        {
+          if (row[j] < null_value)
+            {
+              row_min[i] = qMin (row_min[i], row[j]);
+              row_max[i] = qMax (row_max[i], row[j]);
+            }
+        }
+    }
+
+  for (int32_t i = 0 ; i < ct.rows - 1 ; i++)
+    {
+      uint64_t *lower = &valid[i * ct.words], *upper = lower + ct.words;
+
+      for (int32_t w = 0 ; w < ct.words ; w++)
+        cell_ok[i * ct.words + w] = lower[w] & upper[w] & next_bits (lower, w, ct.words) & next_bits (upper, w, ct.words);
+
+
+      //  The last column of points has no cell.
+
+      cell_ok[i * ct.words + (ct.cols - 1) / 64] &= ~((uint64_t) 1 << ((ct.cols - 1) & 63));
+    }
+
+
+  ct.above = above.data ();
+  ct.cell_ok = cell_ok.data ();
+  ct.visited = visited.data ();
+
+
+  //  Classify the points.  Rows that are all above (2) or all below (1) the level don't need to be compared.
+
+  for (int32_t i = 0 ; i < ct.rows ; i++)
+    {
+      uint64_t *bits = &ct.above[i * ct.words];
+
+      if (row_min[i] >= ct.level)
+        {
+          memset (bits, 0xff, ct.words * sizeof (uint64_t));
+          row_state[i] = 2;
+        }
+      else if (row_max[i] < ct.level)
+        {
+          memset (bits, 0, ct.words * sizeof (uint64_t));
+          row_state[i] = 1;
+        }
+      else
+        {
+          ge_bits (&ar[(size_t) (ct.row_start + i) * width + ct.col_start], ct.cols, ct.level, bits);
+          row_state[i] = 0;
+        }
+    }
+
+
+  //  Pass 0 starts lines at edges on the boundary of the valid cells, pass 1 picks up the closed lines.
+
+  for (int32_t pass = 0 ; pass < 2 ; pass++)
+    {
+      for (int32_t i = 0 ; i < ct.rows - 1 ; i++)
+        {
+          if (row_state[i] && row_state[i] == row_state[i + 1]) continue;
+
+
+          uint64_t *lower = &ct.above[i * ct.words], *upper = lower + ct.words;
+
+          for (int32_t w = 0 ; w < ct.words ; w++)
+            {
+              uint64_t mixed = ((lower[w] ^ next_bits (lower, w, ct.words)) | (upper[w] ^ next_bits (upper, w, ct.words)) |
+                                (lower[w] ^ upper[w])) & ct.cell_ok[i * ct.words + w];
+
+              while (mixed)
+                {
+                  int32_t j = w * 64 + lowest_bit (mixed);
+                  int32_t cell_case = cell_type (&ct, i, j);
+
+                  mixed &= mixed - 1;
+
+                  for (int32_t e = 0 ; e < 4 ; e++)
+                    {
+                      if (!(edge_crossed[cell_case] & (1 << e)) || get_bit (ct.visited, edge_id (&ct, i, j, e))) continue;
+
+                      if (pass == 0 && cell_valid (&ct, i + cell_step[e][0], j + cell_step[e][1])) continue;
+
+                      trace_line (&ct, i, j, e, out);
+                    }
+                }
+            }
+        }
+    }
+}
+
+
+
+/*!
+  Join the pieces (all at the same level) of "in" listed in "pieces" into lines by matching their end keys and
+  append the lines to "out".  Pieces that are already closed are copied as they are.
+*/
+
+void contourEngine::chain (contourSet &in, std::vector<int64_t> &pieces, contourSet &out)
+{
+  int64_t count = (int64_t) pieces.size ();
+
+  if (!count) return;
+
+
+  //  Sort the piece ends by key.  Since a key is shared by at most two pieces, equal neighbors are partners.
+
+  std::vector<CONTOUR_END> ends;
+  ends.reserve (count * 2);
+
+  for (int64_t k = 0 ; k < count ; k++)
+    {
+      int64_t p = pieces[k];
+
+      if (in.closed[p])
+        {
+          for (int64_t i = in.first (p) ; i <= in.last (p) ; i++) out.addPoint (in.x[i], in.y[i], in.key[i]);
+          out.endLine (in.level[p], NVTrue);
+          continue;
+        }
+
+      CONTOUR_END end;
+
+      end.key = in.key[in.first (p)];
+      end.piece_end = k * 2;
+      ends.push_back (end);
+
+      end.key = in.key[in.last (p)];
+      end.piece_end = k * 2 + 1;
+      ends.push_back (end);
+    }
+
+  std::sort (ends.begin (), ends.end (), end_less);
+
+
+  std::vector<int64_t> partner (count * 2, -1);
+
+  for (int64_t i = 0 ; i < (int64_t) ends.size () - 1 ; i++)
+    {
+      if (ends[i].key == ends[i + 1].key)
+        {
+          partner[ends[i].piece_end] = ends[i + 1].piece_end;
+          partner[ends[i + 1].piece_end] = ends[i].piece_end;
+          i++;
+        }
+    }
+
+
+  /*  Walk from each unused piece out of its last end until we run out of partners or get back to its first end
+      (closed), then (if it's open) out of its first end.  The walk is saved as signed piece numbers (plus one,
+      negative for a piece that is used backwards).  */
+
+  std::vector<uint8_t> used (count, NVFalse);
+  std::vector<int64_t> forward, backward;
+
+  for (int64_t k = 0 ; k < count ; k++)
+    {
+      if (used[k] || in.closed[pieces[k]]) continue;
+
+      used[k] = NVTrue;
+
+      forward.clear ();
+      backward.clear ();
+      forward.push_back (k + 1);
+
+      uint8_t is_closed = NVFalse;
+      int64_t next = partner[k * 2 + 1];
+
+      while (next >= 0)
+        {
+          if (next == k * 2)
+            {
+              is_closed = NVTrue;
+              break;
+            }
+
+          int64_t q = next >> 1;
+
+          used[q] = NVTrue;
+
+          if (next & 1)
+            {
+              forward.push_back (-(q + 1));
+              next = partner[q * 2];
+            }
+          else
+            {
+              forward.push_back (q + 1);
+              next = partner[q * 2 + 1];
+            }
+        }
+
+      if (!is_closed)
+        {
+          next = partner[k * 2];
+
+          while (next >= 0)
+            {
+              int64_t q = next >> 1;
+
+              used[q] = NVTrue;
+
+              if (next & 1)
+                {
+                  backward.push_back (q + 1);
+                  next = partner[q * 2];
+                }
+              else
+                {
+                  backward.push_back (-(q + 1));
+                  next = partner[q * 2 + 1];
+                }
+            }
+        }
+
+
+      //  Copy the points, leaving out the first point of each piece after the first (it's the last point of the
+      //  piece before it) and, for closed lines, the last point (it's the first point).
+
+      uint8_t first_piece = NVTrue;
+      int64_t back_count = (int64_t) backward.size (), total = back_count + (int64_t) forward.size ();
+
+      for (int64_t n = 0 ; n < total ; n++)
+        {
+          int64_t signed_piece = (n < back_count) ? backward[back_count - 1 - n] : forward[n - back_count];
+          int64_t p = pieces[(signed_piece < 0 ? -signed_piece : signed_piece) - 1];
+          int64_t point_count = in.points (p), skip_first = first_piece ? 0 : 1;
+          int64_t skip_last = (is_closed && n == total - 1) ? 1 : 0;
+
+          for (int64_t i = skip_first ; i < point_count - skip_last ; i++)
+            {
+              int64_t index = (signed_piece > 0) ? in.first (p) + i : in.last (p) - i;
+
+              out.addPoint (in.x[index], in.y[index], in.key[index]);
+            }
+
+          first_piece = NVFalse;
+        }
+
+      out.endLine (in.level[pieces[k]], is_closed);
+    }
+}
+
+
+
+/*!
+  Put the lines of "in" (all at the same level) into the standard order in result.  Open lines start at the
+  smaller of their end keys.  Closed lines start at their smallest key and go toward the smaller of its
+  neighbors.  The lines are sorted by first key.
+*/
+
+void contourEngine::finish (contourSet &in)
+{
+  std::vector<CONTOUR_ORDER> order (in.count ());
+
+  for (int64_t line = 0 ; line < in.count () ; line++)
+    {
+      CONTOUR_ORDER &o = order[line];
+      int64_t first = in.first (line), last = in.last (line), count = in.points (line);
+
+      o.line = line;
+
+      if (in.closed[line] && count > 2)
+        {
+          o.offset = 0;
+          for (int64_t i = 1 ; i < count ; i++) if (in.key[first + i] < in.key[first + o.offset]) o.offset = i;
+
+          o.reversed = (in.key[first + (o.offset + count - 1) % count] < in.key[first + (o.offset + 1) % count]);
+        }
+      else
+        {
+          o.reversed = (in.key[last] < in.key[first]);
+          o.offset = o.reversed ? count - 1 : 0;
+        }
+
+      o.key = in.key[first + o.offset];
+    }
+
+  std::sort (order.begin (), order.end (), order_less);
+
+
+  result.clear ();
+
+  for (size_t n = 0 ; n < order.size () ; n++)
+    {
+      CONTOUR_ORDER &o = order[n];
+      int64_t first = in.first (o.line), count = in.points (o.line);
+
+      for (int64_t i = 0 ; i < count ; i++)
+        {
+          int64_t index = first + (o.reversed ? (o.offset - i + count) % count : (o.offset + i) % count);
+
+          result.addPoint (in.x[index], in.y[index], in.key[index]);
+        }
+
+      result.endLine (in.level[o.line], in.closed[o.line]);
+    }
+}
+
+
+
+//!  Run the threads over the tiles (next_tile starts at 0) and wait for them to finish.
+
+void contourEngine::runThreads (contourThread *thread, int32_t count)
+{
+  next_tile = 0;
+
+  for (int32_t t = 0 ; t < count ; t++) thread[t].start ();
+
+  for (int32_t t = 0 ; t < count ; t++) thread[t].wait ();
+}
+
+
+
+/*!
+  Contour the grid array (cols by rows, row 0 is the southernmost row) at the levels set by setLevels using
+  "threads" threads (0 means use all of the cores).  The lines are in grid coordinates (column, row).  Each
+  level's lines are passed to receiver as soon as they're finished, lowest level first, and are gone when the
+  next level starts.  Returns the number of lines or -1 if the receiver stopped us.
+*/
+
+int64_t contourEngine::generate (float *grid, int32_t cols, int32_t rows, float null, int32_t threads,
+                                 contourReceiver *receiver)
+{
+  int64_t total = 0;
+
+
+  ar = grid;
+  width = cols;
+  height = rows;
+  null_value = null;
+
+  result.clear ();
+
+  if (width < 2 || height < 2 || levels.isEmpty ()) return (0);
+
+
+  tiles_x = (width - 1 + CONTOUR_TILE_SIZE - 1) / CONTOUR_TILE_SIZE;
+  tiles_y = (height - 1 + CONTOUR_TILE_SIZE - 1) / CONTOUR_TILE_SIZE;
+
+  if (threads <= 0) threads = QThread::idealThreadCount ();
+  if (threads > tiles_x * tiles_y) threads = tiles_x * tiles_y;
+  if (threads > MAX_CONTOUR_THREADS) threads = MAX_CONTOUR_THREADS;
+  if (threads < 1) threads = 1;
+
+
+  contourThread *thread = new contourThread[threads];
+
+  for (int32_t t = 0 ; t < threads ; t++) thread[t].setup (this);
+
+
+  //  Get the min and max of each tile so each level only visits the tiles it passes through.
+
+  tile_min.assign (tiles_x * tiles_y, null_value);
+  tile_max.assign (tiles_x * tiles_y, -null_value);
+
+  current_level = -1;
+  runThreads (thread, threads);
+
+
+  contourSet joined, open;
+  std::vector<int64_t> pieces;
+
+  for (current_level = 0 ; current_level < levels.size () ; current_level++)
+    {
+      level = levels[current_level];
+
+      runThreads (thread, threads);
+
+
+      //  Closed lines are done.  Gather the open ones so they can be stitched across the tile seams.
+
+      for (int32_t t = 0 ; t < threads ; t++)
+        {
+          contourSet &lines = thread[t].lines;
+
+          for (int64_t line = 0 ; line < lines.count () ; line++)
+            {
+              contourSet &dest = lines.closed[line] ? joined : open;
+
+              for (int64_t i = lines.first (line) ; i <= lines.last (line) ; i++)
+                dest.addPoint (lines.x[i], lines.y[i], lines.key[i]);
+              dest.endLine (lines.level[line], lines.closed[line]);
+
+              if (!lines.closed[line]) pieces.push_back (open.count () - 1);
+            }
+
+          lines.clear ();
+        }
+
+
+      chain (open, pieces, joined);
+
+      open.clear ();
+      pieces.clear ();
+
+
+      finish (joined);
+
+      joined.clear ();
+
+
+      total += result.count ();
+
+      uint8_t keep_going = receiver->levelDone (result);
+
+      result.clear ();
+
+      if (!keep_going)
+        {
+          total = -1;
+          break;
+        }
+    }
+
+  delete[] thread;
+
+
+  current_level = -1;
+
+  return (total);
+}
+
+
+
+contourThread::contourThread ()
+{
+  engine = NULL;
+}
+
+
+
+void contourThread::setup (contourEngine *eng)
+{
+  engine = eng;
+  lines.clear ();
+}
+
+
+
+void contourThread::run ()
+{
+  int32_t tile;
+
+  while ((tile = engine->nextTile ()) >= 0)
+    {
+      if (engine->rangePass ())
+        {
+          engine->tileRange (tile);
+        }
+      else
+        {
+          engine->traceTile (tile, lines);
+        }
+    }
+}
@@ -0,0 +1,193 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef CONTOURENGINE_H
+#define CONTOURENGINE_H
+
+#include "chrtrGeotiffDef.hpp"
+
+#include <vector>
+
+
+//  Width and height, in grid cells, of the tiles that the contour threads work on.
+
+#define         CONTOUR_TILE_SIZE               1024
+
+
+//  Most contour threads we'll start.
+
+#define         MAX_CONTOUR_THREADS             64
+
+
+/*!
+  A set of contour lines stored back to back in flat arrays.  Line i is made up of points start[i] through
+  start[i + 1] - 1.  Each point has the key of the grid edge it lies on (see contourEngine) so lines can be joined
+  by matching their end keys.  Closed lines don't repeat their first point.  The arrays are std::vectors with 64
+  bit offsets since one level of a very large grid can have more points than a QVector can hold.
+*/
+
+class contourSet
+{
+public:
+
+  contourSet ();
+
+  void clear ();
+  int64_t count () const {return ((int64_t) level.size ());};
+  int64_t first (int64_t line) const {return (start[line]);};
+  int64_t last (int64_t line) const {return (start[line + 1] - 1);};
+  int64_t points (int64_t line) const {return (start[line + 1] - start[line]);};
+  void addPoint (float px, float py, uint64_t k);
+  void endLine (float lvl, uint8_t is_closed);
+
+
+  std::vector<float> x, y;
+
+  std::vector<uint64_t> key;
+
+  std::vector<int64_t> start;
+
+  std::vector<float> level;
+
+  std::vector<uint8_t> closed;
+};
+
+
+
+//!  Gets the finished lines of each level from contourEngine::generate.
+
+class contourReceiver
+{
+public:
+
+  virtual ~contourReceiver () {};
+
+
+  //!  Called with the lines of one level (in the standard order) as soon as it's done.  Return NVFalse to stop.
+
+  virtual uint8_t levelDone (const contourSet &lines) = 0;
+};
+
+
+
+class contourThread;
+
+
+
+/*!
+  Contour generator for the grid array.  The grid cells are split into CONTOUR_TILE_SIZE square tiles that
+  overlap by one row and column of grid points (the tile boundary).  Each tile is traced by marching squares on
+  one of a pool of threads and the pieces that leave a tile are joined to the pieces in the neighboring tiles by
+  matching end keys.  A key is the index of the grid edge the point lies on (2 * (row * width + col), plus one
+  for the vertical edge) so the same crossing gets the same key, and the same position, in both tiles.  Every
+  key is shared by at most two cells so the pieces can only join one way.
+
+  The levels are done one at a time.  All of the tiles that the level passes through are traced by the pool of
+  threads, then the pieces are joined and the finished lines are put in a standard order (closed lines start at
+  their smallest key, open lines start at the smaller of their end keys, and the lines are sorted by first key)
+  and handed to a contourReceiver before the next level is started.  Only one level's points are ever held in
+  memory, and the output doesn't depend on the number of threads or the tile size.  The min and max of every tile
+  are found first so a level only visits the tiles it passes through.
+
+  Within a tile the points are classified against each level into bitmaps (AVX2 or SSE2, picked at run time,
+  with a scalar tail) and the lines are followed from cell to cell using a bitmap of the edges already crossed
+  (see traceTile).
+
+  Cells with a null corner (>= null_value) are not contoured.  A corner equal to the level counts as above it.
+*/
+
+class contourEngine
+{
+public:
+
+  contourEngine ();
+
+  void setLevels (float min_z, float max_z, float interval);
+  int64_t generate (float *grid, int32_t cols, int32_t rows, float null, int32_t threads, contourReceiver *receiver);
+
+  int32_t numLevels () {return (levels.size ());};
+  void tileRange (int32_t tile);
+  void traceTile (int32_t tile, contourSet &out);
+  int32_t nextTile ();
+  uint8_t rangePass () {return (current_level < 0);};
+
+
+protected:
+
+  void runThreads (contourThread *thread, int32_t count);
+  void chain (contourSet &in, std::vector<int64_t> &pieces, contourSet &out);
+  void finish (contourSet &in);
+
+
+  QMutex           mutex;
+
+  QVector<float>   levels;
+
+  std::vector<float> tile_min, tile_max;
+
+  contourSet       result;
+
+  float            *ar, null_value, level;
+
+  int32_t          width, height, tiles_x, tiles_y, next_tile, current_level;
+};
+
+
+
+//!  Worker thread that traces tiles (or gets their min and max) for contourEngine::generate until there are none left.
+
+class contourThread : public QThread
+{
+public:
+
+  contourThread ();
+
+  void setup (contourEngine *eng);
+
+  contourSet       lines;
+
+
+protected:
+
+  void run ();
+
+
+  contourEngine    *engine;
+};
+
+#endif
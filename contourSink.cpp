@@ -0,0 +1,242 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "contourSink.hpp"
+#include "shapeWriter.hpp"
+
+
+contourSink::contourSink ()
+{
+  num_records = 0;
+}
+
+
+
+contourSink::~contourSink ()
+{
+}
+
+
+
+//!  Make a sink for the options.contour_format type.  The caller deletes it.
+
+contourSink *contourSink::create (int32_t format)
+{
+  if (format == CONTOUR_SHAPEFILE) return (new shapeWriter);
+
+  return (new ogrContourSink (format));
+}
+
+
+
+//!  Name of a contour file format (for messages).
+
+const char *contourSink::formatName (int32_t format)
+{
+  switch (format)
+    {
+    case CONTOUR_GPKG:
+      return ("GeoPackage");
+
+    case CONTOUR_FGB:
+      return ("FlatGeobuf");
+    }
+
+  return ("ESRI SHAPE");
+}
+
+
+
+//!  File name extension (including the dot) of a contour file format.
+
+const char *contourSink::extension (int32_t format)
+{
+  switch (format)
+    {
+    case CONTOUR_GPKG:
+      return (".gpkg");
+
+    case CONTOUR_FGB:
+      return (".fgb");
+    }
+
+  return (".shp");
+}
+
+
+
+ogrContourSink::ogrContourSink (int32_t contour_format)
+{
+  format = contour_format;
+  ds = NULL;
+  layer = NULL;
+  level_field = -1;
+  transactions = NVFalse;
+}
+
+
+
+ogrContourSink::~ogrContourSink ()
+{
+  if (ds) close ();
+}
+
+
+
+uint8_t ogrContourSink::setError (QString what)
+{
+  if (error_string.isEmpty ()) error_string = what + QString (" : ") + QString (CPLGetLastErrorMsg ());
+
+  return (NVFalse);
+}
+
+
+
+/*!
+  Create the file (replacing any old one) with one "contours" layer in WGS 84 and start the first transaction.
+*/
+
+uint8_t ogrContourSink::open (char *name)
+{
+  const char *driver_name = (format == CONTOUR_GPKG) ? "GPKG" : "FlatGeobuf";
+
+
+  num_records = 0;
+  error_string = "";
+
+  GDALAllRegister ();
+
+  GDALDriver *driver = GetGDALDriverManager ()->GetDriverByName (driver_name);
+  if (driver == NULL)
+    {
+      error_string = QString (QObject::tr ("GDAL %1 driver is not available")).arg (driver_name);
+      return (NVFalse);
+    }
+
+
+  QFileInfo info (name);
+  if (info.exists ()) driver->Delete (name);
+
+  if ((ds = driver->Create (name, 0, 0, 0, GDT_Unknown, NULL)) == NULL)
+    return (setError (QString (QObject::tr ("Unable to create %1 file %2")).arg (formatName (format)).arg (QDir::toNativeSeparators (QString (name)))));
+
+
+  OGRSpatialReference srs;
+  srs.importFromEPSG (4326);
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,0,0)
+  srs.SetAxisMappingStrategy (OAMS_TRADITIONAL_GIS_ORDER);
+#endif
+
+  char **papszOptions = NULL;
+  papszOptions = CSLSetNameValue (papszOptions, "SPATIAL_INDEX", "YES");
+
+  layer = ds->CreateLayer ("contours", &srs, wkbLineStringM, papszOptions);
+
+  CSLDestroy (papszOptions);
+
+  if (layer == NULL) return (setError (QObject::tr ("Unable to create contour layer")));
+
+
+  OGRFieldDefn field ("level", OFTReal);
+
+  if (layer->CreateField (&field) != OGRERR_NONE) return (setError (QObject::tr ("Unable to create level field")));
+
+  level_field = layer->GetLayerDefn ()->GetFieldIndex ("level");
+
+
+  transactions = ds->TestCapability (ODsCTransactions);
+  if (transactions && ds->StartTransaction () != OGRERR_NONE) transactions = NVFalse;
+
+
+  return (NVTrue);
+}
+
+
+
+//!  Add one LineStringM feature.  The level field is the M of the first point.
+
+uint8_t ogrContourSink::addArcM (int32_t count, double *x, double *y, double *m)
+{
+  if (layer == NULL || !error_string.isEmpty ()) return (NVFalse);
+
+
+  OGRFeature *feature = OGRFeature::CreateFeature (layer->GetLayerDefn ());
+  OGRLineString *line = new OGRLineString;
+
+  line->setPointsM (count, x, y, m);
+  feature->SetGeometryDirectly (line);
+  feature->SetField (level_field, m[0]);
+
+  OGRErr err = layer->CreateFeature (feature);
+
+  OGRFeature::DestroyFeature (feature);
+
+  if (err != OGRERR_NONE) return (setError (QObject::tr ("Unable to write contour")));
+
+
+  num_records++;
+
+
+  if (transactions && !(num_records % CONTOUR_TRANSACTION_SIZE))
+    {
+      if (ds->CommitTransaction () != OGRERR_NONE || ds->StartTransaction () != OGRERR_NONE)
+        return (setError (QObject::tr ("Unable to commit contours")));
+    }
+
+
+  return (NVTrue);
+}
+
+
+
+//!  Commit the last transaction and close the file (FlatGeobuf builds its index here).
+
+uint8_t ogrContourSink::close ()
+{
+  if (ds == NULL) return (error_string.isEmpty ());
+
+
+  if (transactions && ds->CommitTransaction () != OGRERR_NONE) setError (QObject::tr ("Unable to commit contours"));
+
+  GDALClose ((GDALDatasetH) ds);
+  ds = NULL;
+  layer = NULL;
+
+
+  return (error_string.isEmpty ());
+}
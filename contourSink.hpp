@@ -0,0 +1,128 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef CONTOURSINK_H
+#define CONTOURSINK_H
+
+#include "chrtrGeotiffDef.hpp"
+
+#include <ogrsf_frmts.h>
+
+
+//  Number of features written in each OGR transaction.
+
+#define         CONTOUR_TRANSACTION_SIZE        10000
+
+
+//  Most points in one contour record.  Every sink takes a 32 bit point count and a shape file record holds 24 bytes
+//  per point with a 32 bit length, so scribe splits longer lines into several records.
+
+#define         CONTOUR_MAX_RECORD_POINTS       50000000
+
+
+/*!
+  Where scribe sends its contours.  A contour is a line with an M (the contour level) for every point.  Each
+  function returns NVFalse on error, errorString describes the error.  Use create to get the sink for one of the
+  options.contour_format types.
+*/
+
+class contourSink
+{
+public:
+
+  contourSink ();
+  virtual ~contourSink ();
+
+  virtual uint8_t open (char *name) = 0;
+  virtual uint8_t addArcM (int32_t count, double *x, double *y, double *m) = 0;
+  virtual uint8_t close () = 0;
+
+  QString errorString () {return (error_string);};
+  int32_t records () {return (num_records);};
+
+  static contourSink *create (int32_t format);
+  static const char *formatName (int32_t format);
+  static const char *extension (int32_t format);
+
+
+protected:
+
+  QString          error_string;
+
+  int32_t          num_records;
+};
+
+
+
+/*!
+  Contour sink that streams LineStringM features (with a "level" field) into a GeoPackage or FlatGeobuf file
+  through OGR.  Both are written with a spatial index (GeoPackage keeps an R-tree, FlatGeobuf writes a packed
+  Hilbert R-tree when the file is closed) so a viewer can pull out the contours in its window without reading
+  the whole file.  When the driver supports transactions the features are committed every
+  CONTOUR_TRANSACTION_SIZE features instead of one at a time.
+*/
+
+class ogrContourSink : public contourSink
+{
+public:
+
+  ogrContourSink (int32_t contour_format);
+  ~ogrContourSink ();
+
+  uint8_t open (char *name);
+  uint8_t addArcM (int32_t count, double *x, double *y, double *m);
+  uint8_t close ();
+
+
+protected:
+
+  uint8_t setError (QString what);
+
+
+  int32_t          format;
+
+  GDALDataset      *ds;
+
+  OGRLayer         *layer;
+
+  int32_t          level_field;
+
+  uint8_t          transactions;
+};
+
+#endif
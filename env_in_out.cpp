@@ -103,8 +103,26 @@ void envin (OPTIONS *options)
 
   options->caris = settings.value (QString ("caris format"), options->caris).toBool ();
 
+  options->cog = settings.value (QString ("cloud optimized format"), options->cog).toBool ();
+
+  options->codec = settings.value (QString ("compression codec"), options->codec).toInt ();
+
+  options->codec_level = settings.value (QString ("compression level"), options->codec_level).toInt ();
+
   options->grey = settings.value (QString ("32 bit floating point format"), options->grey).toBool ();
 
+  options->tiled = settings.value (QString ("tiled format"), options->tiled).toBool ();
+
+  options->tile_width = settings.value (QString ("tile width"), options->tile_width).toInt ();
+
+  options->tile_height = settings.value (QString ("tile height"), options->tile_height).toInt ();
+
+  options->overviews = settings.value (QString ("overviews flag"), options->overviews).toBool ();
+
+  options->ov_color_resampling = settings.value (QString ("overview color resampling"), options->ov_color_resampling).toInt ();
+
+  options->ov_grey_resampling = settings.value (QString ("overview grey resampling"), options->ov_grey_resampling).toInt ();
+
   options->restart = settings.value (QString ("restart"), options->restart).toBool ();
 
   options->azimuth = (float) settings.value (QString ("azimuth"), (double) options->azimuth).toDouble ();
@@ -129,6 +147,20 @@ void envin (OPTIONS *options)
 
   options->cint = (float) settings.value (QString ("contour interval"), (double) options->cint).toDouble ();
 
+  options->contour_format = settings.value (QString ("contour format"), options->contour_format).toInt ();
+
+  options->num_threads = settings.value (QString ("number of threads"), options->num_threads).toInt ();
+
+  options->compress_threads = settings.value (QString ("number of compression threads"), options->compress_threads).toInt ();
+
+  options->stream = settings.value (QString ("streaming flag"), options->stream).toBool ();
+
+  options->grid_cache = settings.value (QString ("grid cache flag"), options->grid_cache).toBool ();
+
+  options->cache_dir = settings.value (QString ("grid cache directory"), options->cache_dir).toString ();
+
+  options->stats_index = settings.value (QString ("statistics index flag"), options->stats_index).toBool ();
+
   options->input_dir = settings.value (QString ("input directory"), options->input_dir).toString ();
   options->output_dir = settings.value (QString ("output directory"), options->output_dir).toString ();
   options->area_dir = settings.value (QString ("area directory"), options->area_dir).toString ();
@@ -167,8 +199,26 @@ void envout (OPTIONS *options)
 
   settings.setValue (QString ("caris format"), options->caris);
 
+  settings.setValue (QString ("cloud optimized format"), options->cog);
+
+  settings.setValue (QString ("compression codec"), options->codec);
+
+  settings.setValue (QString ("compression level"), options->codec_level);
+
   settings.setValue (QString ("32 bit floating point format"), options->grey);
 
+  settings.setValue (QString ("tiled format"), options->tiled);
+
+  settings.setValue (QString ("tile width"), options->tile_width);
+
+  settings.setValue (QString ("tile height"), options->tile_height);
+
+  settings.setValue (QString ("overviews flag"), options->overviews);
+
+  settings.setValue (QString ("overview color resampling"), options->ov_color_resampling);
+
+  settings.setValue (QString ("overview grey resampling"), options->ov_grey_resampling);
+
   settings.setValue (QString ("restart"), options->restart);
 
   settings.setValue (QString ("azimuth"), (double) options->azimuth);
@@ -193,6 +243,20 @@ void envout (OPTIONS *options)
 
   settings.setValue (QString ("contour interval"), (double) options->cint);
 
+  settings.setValue (QString ("contour format"), options->contour_format);
+
+  settings.setValue (QString ("number of threads"), options->num_threads);
+
+  settings.setValue (QString ("number of compression threads"), options->compress_threads);
+
+  settings.setValue (QString ("streaming flag"), options->stream);
+
+  settings.setValue (QString ("grid cache flag"), options->grid_cache);
+
+  settings.setValue (QString ("grid cache directory"), options->cache_dir);
+
+  settings.setValue (QString ("statistics index flag"), options->stats_index);
+
   settings.setValue (QString ("input directory"), options->input_dir);
   settings.setValue (QString ("output directory"), options->output_dir);
   settings.setValue (QString ("area directory"), options->area_dir);
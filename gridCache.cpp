@@ -0,0 +1,427 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "gridCache.hpp"
+
+#include <sys/stat.h>
+
+#ifndef NVWIN3X
+#include <sys/mman.h>
+#endif
+
+
+//  Written into the header in the native byte order so a file from a machine with the other byte order isn't used.
+
+#define         GRID_CACHE_BYTE_ORDER           0x01020304
+
+
+gridCache::gridCache ()
+{
+  width = height = 0;
+  source_mtime = source_size = 0;
+  fp = NULL;
+  grid = NULL;
+  null_value = 0.0;
+  map_addr = NULL;
+  map_size = 0;
+}
+
+
+
+gridCache::~gridCache ()
+{
+  discard ();
+  close ();
+}
+
+
+
+/*!
+  Build the key, and the cache file name, for a cols by rows window starting at x_start, y_start in chrtr_name
+  (optionally masked by area_name).  The cache files go in "cache_dir".
+*/
+
+void gridCache::setKey (QString cache_dir, char *chrtr_name, char *area_name, int32_t x_start, int32_t y_start, int32_t cols,
+                        int32_t rows, OPTIONS *options)
+{
+  struct stat st;
+
+
+  close ();
+  discard ();
+
+  dir = cache_dir;
+  width = cols;
+  height = rows;
+
+
+  source_mtime = source_size = 0;
+  if (!stat (chrtr_name, &st))
+    {
+      source_mtime = (int64_t) st.st_mtime;
+      source_size = (int64_t) st.st_size;
+    }
+
+  QString chrtr_path = QFileInfo (QString (chrtr_name)).absoluteFilePath ();
+
+  QString text = QString ("chrtr %1\nmtime %2\nsize %3\n").arg (chrtr_path).arg ((qlonglong) source_mtime).arg ((qlonglong) source_size);
+
+
+  //  The area file masks the grid so its contents matter too.
+
+  if (area_name != NULL && strlen (area_name))
+    {
+      int64_t area_mtime = 0, area_size = 0;
+
+      if (!stat (area_name, &st))
+        {
+          area_mtime = (int64_t) st.st_mtime;
+          area_size = (int64_t) st.st_size;
+        }
+
+      text += QString ("area %1\nmtime %2\nsize %3\n").arg (QFileInfo (QString (area_name)).absoluteFilePath ())
+        .arg ((qlonglong) area_mtime).arg ((qlonglong) area_size);
+    }
+
+  text += QString ("window %1 %2 %3 %4\n").arg (x_start).arg (y_start).arg (cols).arg (rows);
+  text += QString ("units %1\ndumb %2\nelev %3\nchrtr2 %4\n").arg (options->units).arg (options->dumb).arg (options->elev)
+    .arg (options->chrtr2);
+
+
+  key = text.toUtf8 ();
+
+
+  //  The key has to fit in the header (with its NULL).  If it doesn't we just won't cache this grid.
+
+  if (key.size () >= GRID_CACHE_KEY_SIZE) key.clear ();
+
+
+  prefix = QString (QCryptographicHash::hash (chrtr_path.toUtf8 (), QCryptographicHash::Sha1).toHex ().left (16));
+  path = dir + "/" + prefix + "-" + QString (QCryptographicHash::hash (key, QCryptographicHash::Sha1).toHex ().left (24)) + ".grid";
+}
+
+
+
+//!  Check a cache file header against the current key.
+
+static uint8_t header_ok (GRID_CACHE_HEADER *header, QByteArray &key, int32_t width, int32_t height)
+{
+  if (strncmp (header->magic, "CHRTRGC", 8)) return (NVFalse);
+  if (header->byte_order != GRID_CACHE_BYTE_ORDER || header->version != GRID_CACHE_VERSION) return (NVFalse);
+  if (header->width != width || header->height != height) return (NVFalse);
+
+  return (!memcmp (header->key, key.constData (), key.size () + 1));
+}
+
+
+
+/*!
+  Map the cached grid if there's a complete cache file for the current key.  Returns the grid (height rows of
+  width floats, south row first) and sets min_z and max_z or returns NULL if the grid isn't cached.  The grid stays
+  valid until close is called.  Changes to it are private to this run.
+*/
+
+float *gridCache::map (float *min_z, float *max_z)
+{
+  GRID_CACHE_HEADER header;
+
+
+  close ();
+
+  if (key.isEmpty ()) return (NULL);
+
+
+  FILE *cfp = fopen (path.toLatin1 (), "rb");
+  if (cfp == NULL) return (NULL);
+
+  if (fread (&header, sizeof (GRID_CACHE_HEADER), 1, cfp) != 1 || !header_ok (&header, key, width, height))
+    {
+      fclose (cfp);
+      return (NULL);
+    }
+
+
+  size_t grid_bytes = (size_t) width * (size_t) height * sizeof (float);
+
+#ifndef NVWIN3X
+  struct stat st;
+
+  if (fstat (fileno (cfp), &st) || (size_t) st.st_size != GRID_CACHE_HEADER_SIZE + grid_bytes)
+    {
+      fclose (cfp);
+      return (NULL);
+    }
+
+
+  //  Private, writable mapping so the grid can be used just like one we allocated.
+
+  void *addr = mmap (NULL, GRID_CACHE_HEADER_SIZE + grid_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE, fileno (cfp), 0);
+
+  fclose (cfp);
+
+  if (addr == MAP_FAILED) return (NULL);
+
+  map_addr = addr;
+  map_size = GRID_CACHE_HEADER_SIZE + grid_bytes;
+  grid = (float *) ((char *) addr + GRID_CACHE_HEADER_SIZE);
+#else
+  grid = (float *) malloc (grid_bytes);
+
+  if (grid == NULL || fseek (cfp, GRID_CACHE_HEADER_SIZE, SEEK_SET) || fread (grid, grid_bytes, 1, cfp) != 1)
+    {
+      if (grid) free (grid);
+      grid = NULL;
+      fclose (cfp);
+      return (NULL);
+    }
+
+  fclose (cfp);
+#endif
+
+
+  *min_z = header.min_z;
+  *max_z = header.max_z;
+
+
+  return (grid);
+}
+
+
+
+//!  Start a new cache file for the current key.  The rows are added with write and the file is completed by finish.
+
+int32_t gridCache::create (float null)
+{
+  discard ();
+
+  if (key.isEmpty ())
+    {
+      error_string = QObject::tr ("Cache key is too long");
+      return (-1);
+    }
+
+
+  if (!QDir ().mkpath (dir))
+    {
+      error_string = QObject::tr ("Unable to create cache directory %1").arg (dir);
+      return (-1);
+    }
+
+
+  null_value = null;
+
+  temp_path = path + QString (".%1.tmp").arg ((qlonglong) QCoreApplication::applicationPid ());
+
+  if ((fp = fopen (temp_path.toLatin1 (), "wb")) == NULL)
+    {
+      error_string = QObject::tr ("Unable to create cache file %1 : %2").arg (temp_path).arg (QString (strerror (errno)));
+      return (-1);
+    }
+
+
+  //  Leave room for the header.  It's written by finish once we know the min and max.
+
+  char *blank = (char *) calloc (GRID_CACHE_HEADER_SIZE, 1);
+
+  size_t written = (blank != NULL) ? fwrite (blank, GRID_CACHE_HEADER_SIZE, 1, fp) : 0;
+
+  if (blank) free (blank);
+
+  if (written != 1)
+    {
+      error_string = QObject::tr ("Unable to write cache file %1 : %2").arg (temp_path).arg (QString (strerror (errno)));
+      discard ();
+      return (-1);
+    }
+
+
+  return (0);
+}
+
+
+
+//!  Add "count" rows (the next rows north) to the cache file.
+
+int32_t gridCache::write (float *rows, int32_t count)
+{
+  if (fp == NULL) return (-1);
+
+
+  if (fwrite (rows, (size_t) width * sizeof (float), count, fp) != (size_t) count)
+    {
+      error_string = QObject::tr ("Unable to write cache file %1 : %2").arg (temp_path).arg (QString (strerror (errno)));
+      discard ();
+      return (-1);
+    }
+
+
+  return (0);
+}
+
+
+
+//!  Write the header, give the file its real name, and remove any out of date cache files for the same CHRTR file.
+
+int32_t gridCache::finish (float min_z, float max_z)
+{
+  GRID_CACHE_HEADER *header;
+
+
+  if (fp == NULL) return (-1);
+
+
+  header = (GRID_CACHE_HEADER *) calloc (GRID_CACHE_HEADER_SIZE, 1);
+  if (header == NULL)
+    {
+      error_string = QObject::tr ("Unable to allocate cache header : ") + QString (strerror (errno));
+      discard ();
+      return (-1);
+    }
+
+  strcpy (header->magic, "CHRTRGC");
+  header->byte_order = GRID_CACHE_BYTE_ORDER;
+  header->version = GRID_CACHE_VERSION;
+  header->width = width;
+  header->height = height;
+  header->source_mtime = source_mtime;
+  header->source_size = source_size;
+  header->min_z = min_z;
+  header->max_z = max_z;
+  header->null_value = null_value;
+  memcpy (header->key, key.constData (), key.size ());
+
+  int32_t status = (fseek (fp, 0, SEEK_SET) || fwrite (header, GRID_CACHE_HEADER_SIZE, 1, fp) != 1);
+
+  free (header);
+
+  if (fclose (fp)) status = 1;
+  fp = NULL;
+
+  if (status)
+    {
+      error_string = QObject::tr ("Unable to write cache file %1 : %2").arg (temp_path).arg (QString (strerror (errno)));
+      QFile::remove (temp_path);
+      return (-1);
+    }
+
+
+  QFile::remove (path);
+
+  if (!QFile::rename (temp_path, path))
+    {
+      error_string = QObject::tr ("Unable to rename %1 to %2").arg (temp_path).arg (path);
+      QFile::remove (temp_path);
+      return (-1);
+    }
+
+
+  purge ();
+
+
+  return (0);
+}
+
+
+
+//!  Throw away a cache file that hasn't been finished.
+
+void gridCache::discard ()
+{
+  if (fp)
+    {
+      fclose (fp);
+      fp = NULL;
+
+      QFile::remove (temp_path);
+    }
+}
+
+
+
+/*!
+  Remove the cache files for the same CHRTR file (same path hash) that were made from a different version of it
+  (modification time or size).  Files for other windows or options of the current version are left alone.
+*/
+
+void gridCache::purge ()
+{
+  QDir cache (dir);
+  QStringList files = cache.entryList (QStringList () << prefix + "-*.grid", QDir::Files);
+  QString name = QFileInfo (path).fileName ();
+
+
+  for (int32_t i = 0 ; i < files.size () ; i++)
+    {
+      if (files.at (i) == name) continue;
+
+
+      QString other = dir + "/" + files.at (i);
+      GRID_CACHE_HEADER header;
+      uint8_t stale = NVTrue;
+
+      FILE *cfp = fopen (other.toLatin1 (), "rb");
+      if (cfp == NULL) continue;
+
+      if (fread (&header, sizeof (GRID_CACHE_HEADER), 1, cfp) == 1 && !strncmp (header.magic, "CHRTRGC", 8) &&
+          header.source_mtime == source_mtime && header.source_size == source_size) stale = NVFalse;
+
+      fclose (cfp);
+
+      if (stale) QFile::remove (other);
+    }
+}
+
+
+
+//!  Unmap (or free) the cached grid.  Safe to call more than once.
+
+void gridCache::close ()
+{
+#ifndef NVWIN3X
+  if (map_addr)
+    {
+      munmap (map_addr, map_size);
+      map_addr = NULL;
+      map_size = 0;
+    }
+#else
+  if (grid) free (grid);
+#endif
+
+  grid = NULL;
+}
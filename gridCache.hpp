@@ -0,0 +1,138 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef GRIDCACHE_H
+#define GRIDCACHE_H
+
+#include "chrtrGeotiffDef.hpp"
+
+
+//  The grid starts this far into a cache file (one page, so the mapped grid is page aligned).
+
+#define         GRID_CACHE_HEADER_SIZE          4096
+
+
+//  Bump this if the cache file layout or the way rows are loaded changes.
+
+#define         GRID_CACHE_VERSION              1
+
+
+//  Room for the key text in the header.
+
+#define         GRID_CACHE_KEY_SIZE             3584
+
+
+//  Cache file header.  The grid follows at GRID_CACHE_HEADER_SIZE as height rows of width floats, south row first.
+
+typedef struct
+{
+  char          magic[8];                   //  "CHRTRGC" and a NULL
+  uint32_t      byte_order;                 //  0x01020304 written in the native byte order
+  int32_t       version;                    //  GRID_CACHE_VERSION
+  int32_t       width;
+  int32_t       height;
+  int64_t       source_mtime;               //  Modification time of the CHRTR file when it was cached
+  int64_t       source_size;                //  Size of the CHRTR file when it was cached
+  float         min_z;
+  float         max_z;
+  float         null_value;
+  char          key[GRID_CACHE_KEY_SIZE];   //  Key text (see gridCache::setKey)
+} GRID_CACHE_HEADER;
+
+
+/*!
+  Persistent cache of the loaded grid array.  The grid that chrtrRenderEngine::load builds (the output window
+  after unit conversion, depth/elevation, nulls, and the area mask) is saved, with its min and max, in a binary
+  file in the cache directory.  When the same grid is loaded again it's mapped straight in (copy on write) so
+  changing colors or sunshading doesn't mean reading and converting the CHRTR file again.
+
+  The cache is content addressed.  The key is the text of everything that changes the loaded grid (the CHRTR
+  file's path, modification time, and size, the area file's path, modification time, and size, the window, and
+  the units, dumb, elev, and chrtr2 options) and the file name is made from SHA-1 hashes of the path and the key.
+  The key text is also stored in the header and compared before the grid is used.
+
+  Files are written under a temporary name and renamed when they're complete so a run that dies part way through
+  never leaves a bad cache file.  When a file is cached, cache files for older versions of the same CHRTR file
+  are removed.  On Windows the cache file is read into memory instead of being mapped.
+*/
+
+class gridCache
+{
+public:
+
+  gridCache ();
+  ~gridCache ();
+
+  void setKey (QString dir, char *chrtr_name, char *area_name, int32_t x_start, int32_t y_start, int32_t cols,
+               int32_t rows, OPTIONS *options);
+  float *map (float *min_z, float *max_z);
+  int32_t create (float null_value);
+  int32_t write (float *rows, int32_t count);
+  int32_t finish (float min_z, float max_z);
+  void discard ();
+  void close ();
+
+  uint8_t mapped () {return (grid != NULL);};
+  QString fileName () {return (path);};
+  QString errorString () {return (error_string);};
+
+
+protected:
+
+  void purge ();
+
+
+  QString          dir, prefix, path, temp_path, error_string;
+
+  QByteArray       key;
+
+  int32_t          width, height;
+
+  int64_t          source_mtime, source_size;
+
+  FILE             *fp;
+
+  float            *grid, null_value;
+
+  void             *map_addr;
+
+  size_t           map_size;
+};
+
+
+#endif
@@ -36,6 +36,8 @@
 
 
 
+#include <float.h>
+
 #include "imagePage.hpp"
 #include "imagePageHelp.hpp"
 
@@ -44,6 +46,13 @@ imagePage::imagePage (QWidget *parent, OPTIONS *op):
 {
   options = op;
   hold_display = NVFalse;
+  preview_generation = 0;
+
+
+  //  The preview is built on a separate thread.  The images come back through a queued connection.
+
+  preview = new previewThread (this);
+  connect (preview, SIGNAL (previewReady (QImage, int, int)), this, SLOT (slotPreviewReady (QImage, int, int)));
 
 
   setTitle (tr ("Image parameters"));
@@ -270,6 +279,21 @@ imagePage::imagePage (QWidget *parent, OPTIONS *op):
   hbox->addWidget (sBox);
 
 
+  QGroupBox *vBox = new QGroupBox (tr ("Preview"), this);
+  QVBoxLayout *vBoxLayout = new QVBoxLayout;
+  vBox->setLayout (vBoxLayout);
+
+  preview_label = new QLabel (vBox);
+  preview_label->setFixedSize (PREVIEW_SIZE, PREVIEW_SIZE);
+  preview_label->setAlignment (Qt::AlignCenter);
+  preview_label->setToolTip (tr ("Preview of the input file using the current parameters"));
+  preview_label->setWhatsThis (previewText);
+  vBoxLayout->addWidget (preview_label);
+
+
+  hbox->addWidget (vBox);
+
+
   QGroupBox *rBox = new QGroupBox (tr ("Restart color map at zero"), this);
   QHBoxLayout *rBoxLayout = new QHBoxLayout;
   rBox->setLayout (rBoxLayout);
@@ -320,6 +344,42 @@ void imagePage::enable (uint8_t state)
 
 
 
+//!  Set the CHRTR/CHRTR2 file to be previewed.  This is called before enable so the preview will be started there.
+
+void imagePage::setPreviewFile (QString name, uint8_t chrtr2)
+{
+  preview->cancel ();
+
+  preview->setFile (name, chrtr2);
+
+  preview_label->clear ();
+}
+
+
+
+//!  Stop the preview thread so it isn't reading the file while it's being converted.
+
+void imagePage::stopPreview ()
+{
+  preview->cancel ();
+}
+
+
+
+//!  Show a preview image unless it came from a run that has since been cancelled.
+
+void imagePage::slotPreviewReady (QImage image, int pass __attribute__ ((unused)), int gen)
+{
+  if (gen != preview_generation) return;
+
+
+  //  Every pass is blown up to fill the label so the coarse ones show up as blocks that sharpen in place.
+
+  preview_label->setPixmap (QPixmap::fromImage (image.scaled (PREVIEW_SIZE, PREVIEW_SIZE, Qt::KeepAspectRatio)));
+}
+
+
+
 void imagePage::slotRestartClicked ()
 {
   if (restart_check->checkState ())
@@ -411,8 +471,8 @@ void imagePage::slotSampleGroupClicked (int id)
 
 void imagePage::display_sample_data ()
 {
-  float               row[2][SAMPLE_WIDTH], range[2] = {0.0, 0.0}, shade_factor;
-  int32_t             c_index = 0, hue, sat;
+  float               row[2][SAMPLE_WIDTH], range[2] = {0.0, 0.0}, shade[SAMPLE_WIDTH];
+  int32_t             c_index[SAMPLE_WIDTH], hue, sat;
   uint8_t             cross_zero = NVFalse;
 
   void palshd (int num_shades, int num_hues, float start_hue, float end_hue, 
@@ -502,45 +562,27 @@ void imagePage::display_sample_data ()
 
       if (i && i < SAMPLE_HEIGHT)
         {
-          for (int32_t k = 0 ; k < SAMPLE_WIDTH ; k++)
-            {
-              if (cross_zero)
-                {
-                  if (row[0][k] < 0.0)
-                    {
-                      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((row[0][k] - options->sample_min) / range[0] * 
-                                                                         NUMHUES))) * NUMSHADES;
-                    }
-                  else
-                    {
-                      c_index = (int32_t) (NUMHUES - (int32_t) (fabsf (row[0][k]) / range[1] * NUMHUES)) *
-                        NUMSHADES;
-                    }
-                }
-              else
-                {
-                  c_index = (int32_t) (NUMHUES - (int32_t) (fabsf ((row[0][k] - options->sample_min) / range[0] * NUMHUES))) *
-                    NUMSHADES;
-                }
-
-
-              //  IMPORTANT NOTE: The cell sizes are hardwired for the sample data in icons/data.dat.  I wouldn't
-              //  recommend trying to change any of this.
+          //  IMPORTANT NOTE: The cell sizes are hardwired for the sample data in icons/data.dat.  I wouldn't
+          //  recommend trying to change any of this.  The sample data has no nulls.
 
-              shade_factor = sunshade (row[0], row[1], k, &options->sunopts, 185.0, 185.0);
+          sunshade_row (row[0], row[1], SAMPLE_WIDTH, &options->sunopts, 185.0, 185.0, FLT_MAX, shade);
 
-              if (shade_factor < 0.0) shade_factor = options->sunopts.min_shade;
 
-              if (shade_factor > 1.0) shade_factor = 1.0;
+          for (int32_t k = 0 ; k < SAMPLE_WIDTH ; k++)
+            {
+              if (shade[k] > 1.0) shade[k] = 1.0;
+            }
 
-              c_index -= NINT (NUMSHADES * shade_factor + 0.5);
+          color_index_row (row[0], shade, SAMPLE_WIDTH, options->sample_min, range, cross_zero, FLT_MAX, c_index);
 
 
+          for (int32_t k = 0 ; k < SAMPLE_WIDTH ; k++)
+            {
               painter.setPen (Qt::NoPen);
 
               brush.setStyle (Qt::SolidPattern);
-              brush.setColor (options->color_array[c_index]);
-              painter.setPen (options->color_array[c_index]);
+              brush.setColor (options->color_array[c_index[k]]);
+              painter.setPen (options->color_array[c_index[k]]);
 
               painter.fillRect (k, SAMPLE_HEIGHT - i, 1, 1, brush);
             }
@@ -550,4 +592,35 @@ void imagePage::display_sample_data ()
   painter.end ();
 
   sample_label->setPixmap (options->sample_pixmap);
+
+
+  display_preview ();
+}
+
+
+
+/*!
+  Restart the preview with the parameters that display_sample_data just set.  Whatever the preview thread was
+  doing is cancelled first.  The levels it has already built are kept so the finest of them is shaded again right
+  away and only the levels that weren't finished are read from the file.  There's no preview for 32 bit grey
+  scale output since none of these parameters are used.
+*/
+
+void imagePage::display_preview ()
+{
+  preview->cancel ();
+
+
+  preview_generation++;
+
+
+  if (options->grey)
+    {
+      preview_label->clear ();
+      return;
+    }
+
+  preview->setParams (options, restart_check->isChecked (), preview_generation);
+
+  preview->start (QThread::LowPriority);
 }
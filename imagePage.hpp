@@ -41,6 +41,7 @@
 
 
 #include "chrtrGeotiffDef.hpp"
+#include "previewThread.hpp"
 
 
 class imagePage:public QWizardPage
@@ -52,6 +53,8 @@ public:
 
   imagePage (QWidget *parent = 0, OPTIONS *op = NULL);
   void enable (uint8_t state);
+  void setPreviewFile (QString name, uint8_t chrtr2);
+  void stopPreview ();
 
 
 signals:
@@ -60,13 +63,18 @@ signals:
 protected:
 
   void display_sample_data ();
+  void display_preview ();
 
 
   OPTIONS          *options;
 
   uint8_t          hold_display;
 
-  QLabel           *sample_label, *startLabel, *endLabel;
+  previewThread    *preview;
+
+  int32_t          preview_generation;
+
+  QLabel           *sample_label, *startLabel, *endLabel, *preview_label;
 
   QCheckBox        *restart_check;
 
@@ -82,6 +90,7 @@ protected slots:
   void slotRestartClicked ();
   void slotParamChanged (double d __attribute__ ((unused)));
   void slotSampleGroupClicked (int id);
+  void slotPreviewReady (QImage image, int pass, int gen);
 
 
 private:
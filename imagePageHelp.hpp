@@ -88,3 +88,11 @@ QString sample4Text =
 
 QString sample5Text = 
   imagePage::tr ("Sets the color values to produce a full color magenta to green image.");
+
+QString previewText = 
+  imagePage::tr ("This is a preview of the input CHRTR file shaded and colored with the current settings.  It is "
+                 "built in the background from a reduced copy of the grid.  A coarse image shows up first and gets "
+                 "sharper as finer copies are read.  Changing any of the settings starts it over but the copies that "
+                 "have already been read are reused so only the shading has to be redone.  The colors are scaled to "
+                 "the min and max of the reduced grid so they may be a little different from the final GeoTIFF.  "
+                 "Empty cells are not drawn.");
@@ -56,6 +56,23 @@
 
 int main (int argc, char **argv)
 {
+    int32_t batch (int32_t argc, char **argv);
+
+
+    //  If --batch is anywhere on the command line we skip the wizard entirely.  We only need a QCoreApplication
+    //  (no display connection, no widgets) so that the Qt classes in OPTIONS are happy.
+
+    for (int32_t i = 1 ; i < argc ; i++)
+      {
+        if (!strcmp (argv[i], "--batch"))
+          {
+            QCoreApplication c (argc, argv);
+
+            return (batch (argc, argv));
+          }
+      }
+
+
     QApplication a (argc, argv);
 
 
@@ -0,0 +1,364 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+#include <float.h>
+
+#include "previewThread.hpp"
+
+
+previewThread::previewThread (QObject *parent):
+  QThread (parent)
+{
+  chrtr2 = abort_flag = restart = units = dumb = elev = opened = NVFalse;
+  generation = src_width = src_height = 0;
+  x_cell_size = y_cell_size = 0.0;
+  null_value = 0.0;
+
+  for (int32_t pass = 0 ; pass < PREVIEW_PASSES ; pass++) level_width[pass] = level_height[pass] = 0;
+}
+
+
+
+previewThread::~previewThread ()
+{
+  cancel ();
+}
+
+
+
+//!  Set the CHRTR/CHRTR2 file to preview.  The saved levels are thrown away if the file has changed.
+
+void previewThread::setFile (QString name, uint8_t chrtr2_flag)
+{
+  if (name == file_name && chrtr2_flag == chrtr2) return;
+
+
+  file_name = name;
+  chrtr2 = chrtr2_flag;
+
+  for (int32_t pass = 0 ; pass < PREVIEW_PASSES ; pass++)
+    {
+      level[pass].clear ();
+      level_width[pass] = level_height[pass] = 0;
+    }
+
+  src_width = src_height = 0;
+}
+
+
+
+/*!
+  Take a copy of the shading and coloring parameters (sunopts and color_array, which display_sample_data has just
+  set) and of the units, dumb, and elev options so the GUI can change them while we're running.  "gen" is passed
+  back with each image so the page can drop images from an earlier (cancelled) run that were already queued.
+*/
+
+void previewThread::setParams (OPTIONS *options, uint8_t restart_flag, int32_t gen)
+{
+  sunopts = options->sunopts;
+  restart = restart_flag;
+  units = options->units;
+  dumb = options->dumb;
+  elev = options->elev;
+  generation = gen;
+
+  color_lut.resize (NUMSHADES * (NUMHUES + 1));
+
+  for (int32_t i = 0 ; i < NUMSHADES * (NUMHUES + 1) ; i++) color_lut[i] = options->color_array[i].rgb ();
+}
+
+
+
+//!  Stop the thread (if it's running) and wait for it to finish.
+
+void previewThread::cancel ()
+{
+  mutex.lock ();
+  abort_flag = NVTrue;
+  mutex.unlock ();
+
+  wait ();
+
+  abort_flag = NVFalse;
+}
+
+
+
+uint8_t previewThread::cancelled ()
+{
+  QMutexLocker lock (&mutex);
+
+  return (abort_flag);
+}
+
+
+
+/*!
+  Shade the finest level we already have and then build, shade, and send each of the finer ones.  The file is only
+  opened if there is a level left to build and it's closed again when we're done so we don't hold it open while
+  the user is sitting on the image page.
+*/
+
+void previewThread::run ()
+{
+  int32_t first = 0;
+
+
+  if (file_name.isEmpty ()) return;
+
+
+  for (int32_t pass = 1 ; pass < PREVIEW_PASSES ; pass++)
+    {
+      if (!level[pass].isEmpty ()) first = pass;
+    }
+
+
+  for (int32_t pass = first ; pass < PREVIEW_PASSES ; pass++)
+    {
+      if (level[pass].isEmpty () && decimate (pass)) break;
+
+      if (cancelled ()) break;
+
+      emit previewReady (shade (pass), pass, generation);
+    }
+
+
+  if (opened)
+    {
+      reader.close ();
+      opened = NVFalse;
+    }
+}
+
+
+
+/*!
+  Build level "pass" from the file.  Preview row 0 is the southernmost row, like the file.  Each preview row
+  covers a span of file rows and each preview column a span of file columns.  The coarse levels read the middle
+  row of the span, the last level reads up to PREVIEW_AVERAGE_ROWS rows spread evenly through it, and every valid
+  cell in the column span of the rows that were read goes into the average.  The level is only saved if it was
+  finished.  Returns -1 if the file couldn't be opened or we were cancelled.
+*/
+
+int32_t previewThread::decimate (int32_t pass)
+{
+  if (!opened)
+    {
+      char name[1024];
+
+      strcpy (name, file_name.toLatin1 ());
+
+      if (reader.open (name, chrtr2)) return (-1);
+
+      opened = NVTrue;
+
+
+      //  Same cell sizes as chrtrRenderEngine::open so the shading matches the GeoTIFF.
+
+      NV_F64_MBR mbr = reader.bounds ();
+
+      src_width = reader.cols ();
+      src_height = reader.rows ();
+      null_value = reader.nullValue ();
+      x_cell_size = reader.xCellDegrees () * 111120.0 * cos ((mbr.nlat - mbr.slat) * 0.0174532925199432957692);
+      y_cell_size = reader.yCellDegrees () * 111120.0;
+    }
+
+
+  //  Size of the finest level (keeping the aspect ratio of the grid but never more cells than the grid has),
+  //  halved for each pass before the last.
+
+  int32_t w, h, shift = PREVIEW_PASSES - 1 - pass;
+
+  if (src_width >= src_height)
+    {
+      w = qMin (src_width, PREVIEW_SIZE);
+      h = qMax (1, (int32_t) ((int64_t) w * src_height / src_width));
+    }
+  else
+    {
+      h = qMin (src_height, PREVIEW_SIZE);
+      w = qMax (1, (int32_t) ((int64_t) h * src_width / src_height));
+    }
+
+  w = qMax (1, w >> shift);
+  h = qMax (1, h >> shift);
+
+
+  QVector<float> data (w * h), row (src_width);
+  QVector<double> sum (w);
+  QVector<int32_t> count (w), col_start (w + 1);
+
+  for (int32_t c = 0 ; c <= w ; c++) col_start[c] = (int32_t) ((int64_t) c * src_width / w);
+
+
+  for (int32_t r = 0 ; r < h ; r++)
+    {
+      int32_t start = (int32_t) ((int64_t) r * src_height / h);
+      int32_t span = (int32_t) ((int64_t) (r + 1) * src_height / h) - start;
+      int32_t samples = (pass == PREVIEW_PASSES - 1) ? qMin (span, PREVIEW_AVERAGE_ROWS) : 1;
+
+      sum.fill (0.0);
+      count.fill (0);
+
+
+      for (int32_t k = 0 ; k < samples ; k++)
+        {
+          if (cancelled ()) return (-1);
+
+          reader.readRow (start + (int32_t) ((int64_t) (2 * k + 1) * span / (2 * samples)), 0, src_width, row.data ());
+
+          for (int32_t c = 0 ; c < w ; c++)
+            {
+              for (int32_t j = col_start[c] ; j < col_start[c + 1] ; j++)
+                {
+                  if (row[j] != null_value)
+                    {
+                      sum[c] += row[j];
+                      count[c]++;
+                    }
+                }
+            }
+        }
+
+
+      for (int32_t c = 0 ; c < w ; c++) data[r * w + c] = count[c] ? (float) (sum[c] / count[c]) : null_value;
+    }
+
+
+  level[pass] = data;
+  level_width[pass] = w;
+  level_height[pass] = h;
+
+
+  return (0);
+}
+
+
+
+/*!
+  Convert (units and depth/elevation, the same way chrtrRenderEngine::convertZ does), sunshade, and color level
+  "pass" into an image.  The color range comes from the min/max of the level so it's close to, but not always
+  exactly, the one the GeoTIFF will use.  Empty cells are transparent.
+*/
+
+QImage previewThread::shade (int32_t pass)
+{
+  int32_t w = level_width[pass], h = level_height[pass];
+  float min_z = FLT_MAX, max_z = -FLT_MAX, range[2];
+  uint8_t cross_zero;
+
+
+  QImage image (w, h, QImage::Format_ARGB32);
+  image.fill (0);
+
+
+  QVector<float> z (level[pass]), shd (w);
+  QVector<int32_t> index (w);
+
+  for (int32_t i = 0 ; i < w * h ; i++)
+    {
+      if (z[i] != null_value)
+        {
+          if (units)
+            {
+              if (dumb)
+                {
+                  z[i] /= 1.875;
+                }
+              else
+                {
+                  z[i] /= 1.8288;
+                }
+            }
+
+          if (elev) z[i] = -z[i];
+
+          min_z = qMin (min_z, z[i]);
+          max_z = qMax (max_z, z[i]);
+        }
+    }
+
+
+  //  Nothing but empty cells.
+
+  if (min_z > max_z) return (image);
+
+
+  if (restart && min_z < 0.0)
+    {
+      range[0] = -min_z;
+      range[1] = max_z;
+
+      cross_zero = NVTrue;
+    }
+  else
+    {
+      range[0] = max_z - min_z;
+
+      cross_zero = NVFalse;
+    }
+
+
+  //  Each preview cell covers this many file cells.
+
+  double x_size = x_cell_size * src_width / w, y_size = y_cell_size * src_height / h;
+
+
+  //  Image row 0 is the northernmost row.  The rows are paired the same way as in the full conversion
+  //  (chrtrRenderEngine::shadeRow), image row k shows level row i + 1 shaded against row i to the south of it
+  //  (the top row is shaded against itself).
+
+  for (int32_t k = 0 ; k < h ; k++)
+    {
+      int32_t i = h - 1 - k;
+      float *next_row = &z[i * w], *current_row = k ? &z[(i + 1) * w] : next_row;
+
+      sunshade_row (next_row, current_row, w, &sunopts, x_size, y_size, null_value, shd.data ());
+
+      color_index_row (current_row, shd.data (), w, min_z, range, cross_zero, null_value, index.data ());
+
+
+      QRgb *line = (QRgb *) image.scanLine (k);
+
+      for (int32_t j = 0 ; j < w ; j++)
+        {
+          if (index[j] >= 0) line[j] = color_lut[index[j]];
+        }
+    }
+
+
+  return (image);
+}
@@ -0,0 +1,121 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+#ifndef PREVIEWTHREAD_H
+#define PREVIEWTHREAD_H
+
+#include "chrtrGeotiffDef.hpp"
+#include "chrtrReader.hpp"
+
+
+//  Longest side, in pixels, of the finest preview image.
+
+#define         PREVIEW_SIZE                    256
+
+
+//  Number of preview passes.  Each pass is twice the width and height of the one before it and the last one is
+//  PREVIEW_SIZE.
+
+#define         PREVIEW_PASSES                  4
+
+
+//  Most source rows averaged into one row of the last (finest) pass.
+
+#define         PREVIEW_AVERAGE_ROWS            4
+
+
+/*!
+  Background thread that builds the real data preview on the image page.  The CHRTR/CHRTR2 file is decimated
+  into PREVIEW_PASSES levels, coarsest first.  For the coarse levels one source row is read for each preview row
+  and each preview cell is the average of the valid cells in its span of that row.  The last level averages up to
+  PREVIEW_AVERAGE_ROWS rows in each span as well.  Each level is sunshaded and colored with the parameters given
+  to setParams and handed to the page (previewReady) as soon as it's done so the user sees a coarse image right
+  away that gets sharper as the finer levels come in.
+
+  The levels are kept (unconverted) until the file changes so changing a parameter only means shading them
+  again.  The caller must stop the thread (cancel) before calling setFile or setParams.  The thread checks the
+  cancel flag between rows.
+*/
+
+class previewThread : public QThread
+{
+  Q_OBJECT 
+
+
+public:
+
+  previewThread (QObject *parent = 0);
+  ~previewThread ();
+
+  void setFile (QString name, uint8_t chrtr2_flag);
+  void setParams (OPTIONS *options, uint8_t restart_flag, int32_t gen);
+  void cancel ();
+
+
+signals:
+
+  void previewReady (QImage image, int pass, int gen);
+
+
+protected:
+
+  void run ();
+  int32_t decimate (int32_t pass);
+  QImage shade (int32_t pass);
+  uint8_t cancelled ();
+
+
+  chrtrReader      reader;
+
+  QMutex           mutex;
+
+  QString          file_name;
+
+  uint8_t          chrtr2, abort_flag, restart, units, dumb, elev, opened;
+
+  int32_t          generation, src_width, src_height, level_width[PREVIEW_PASSES], level_height[PREVIEW_PASSES];
+
+  QVector<float>   level[PREVIEW_PASSES];
+
+  QVector<QRgb>    color_lut;
+
+  SUN_OPT          sunopts;
+
+  double           x_cell_size, y_cell_size;
+
+  float            null_value;
+};
+
+#endif
@@ -0,0 +1,208 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "renderDataset.hpp"
+
+
+renderDataset::renderDataset (chrtrRenderEngine *eng, int32_t w, int32_t h, int32_t num_bands, uint8_t grey,
+                              int32_t strip_rows, double *trans, const char *wkt, float null)
+{
+  engine = eng;
+  nRasterXSize = w;
+  nRasterYSize = h;
+  bands = num_bands;
+  rows = strip_rows;
+  current_strip = -1;
+  null_value = null;
+
+  for (int32_t i = 0 ; i < 6 ; i++) transform[i] = trans[i];
+
+  //  GDAL 3 keeps the coordinate system as an OGRSpatialReference, GDAL 2 as WKT.  GDAL 2 has no axis mapping
+  //  strategy, it always uses longitude/latitude order.
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,0,0)
+  srs.importFromWkt (wkt);
+  srs.SetAxisMappingStrategy (OAMS_TRADITIONAL_GIS_ORDER);
+#else
+  projection = QByteArray (wkt);
+#endif
+
+
+  for (int32_t i = 0 ; i < bands ; i++) SetBand (i + 1, new renderBand (this, i + 1, grey, strip_rows));
+}
+
+
+
+renderDataset::~renderDataset ()
+{
+}
+
+
+
+CPLErr renderDataset::GetGeoTransform (double *trans)
+{
+  for (int32_t i = 0 ; i < 6 ; i++) trans[i] = transform[i];
+
+  return (CE_None);
+}
+
+
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,0,0)
+
+const OGRSpatialReference *renderDataset::GetSpatialRef () const
+{
+  return (&srs);
+}
+
+#else
+
+const char *renderDataset::GetProjectionRef ()
+{
+  return (projection.constData ());
+}
+
+#endif
+
+
+
+//!  Render strip (block row) "strip" unless it's the one we did last.
+
+void renderDataset::renderStrip (int32_t strip)
+{
+  if (strip == current_strip) return;
+
+  int32_t k_start = strip * rows;
+
+  engine->renderChunk (k_start, qMin (rows, nRasterYSize - k_start));
+
+  current_strip = strip;
+}
+
+
+
+renderBand::renderBand (renderDataset *ds, int32_t band_num, uint8_t grey, int32_t strip_rows)
+{
+  poDS = ds;
+  nBand = band_num;
+  is_grey = grey;
+
+  eDataType = GDT_Byte;
+  if (is_grey) eDataType = GDT_Float32;
+
+  nRasterXSize = ds->GetRasterXSize ();
+  nRasterYSize = ds->GetRasterYSize ();
+  nBlockXSize = nRasterXSize;
+  nBlockYSize = strip_rows;
+}
+
+
+
+/*!
+  Render (if needed) and return one strip of this band.  The rows of the last strip past the bottom of the image
+  are filled with nodata (grey scale) or 0.
+*/
+
+CPLErr renderBand::IReadBlock (int block_x __attribute__ ((unused)), int block_y, void *data)
+{
+  renderDataset *ds = (renderDataset *) poDS;
+
+
+  //  The COG driver may read from more than one thread and the engine only has one set of chunk buffers.
+
+  QMutexLocker lock (&ds->mutex);
+
+
+  ds->renderStrip (block_y);
+
+  int32_t rows = qMin (nBlockYSize, nRasterYSize - block_y * nBlockYSize);
+  size_t count = (size_t) rows * nBlockXSize;
+  size_t block = (size_t) nBlockYSize * nBlockXSize;
+
+  if (is_grey)
+    {
+      float *dest = (float *) data;
+
+      memcpy (dest, ds->engine->chunkGrey (), count * sizeof (float));
+      for (size_t i = count ; i < block ; i++) dest[i] = ds->null_value;
+    }
+  else
+    {
+      uint8_t *pixels = ds->engine->chunkPixels (), *dest = (uint8_t *) data;
+      int32_t bands = ds->bands;
+
+      for (size_t i = 0 ; i < count ; i++) dest[i] = pixels[i * bands + nBand - 1];
+      memset (&dest[count], 0, block - count);
+    }
+
+
+  return (CE_None);
+}
+
+
+
+double renderBand::GetNoDataValue (int *success)
+{
+  renderDataset *ds = (renderDataset *) poDS;
+
+
+  if (success) *success = is_grey;
+
+  return (ds->null_value);
+}
+
+
+
+GDALColorInterp renderBand::GetColorInterpretation ()
+{
+  if (is_grey) return (GCI_GrayIndex);
+
+  switch (nBand)
+    {
+    case 1:
+      return (GCI_RedBand);
+
+    case 2:
+      return (GCI_GreenBand);
+
+    case 3:
+      return (GCI_BlueBand);
+    }
+
+  return (GCI_AlphaBand);
+}
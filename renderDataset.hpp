@@ -0,0 +1,112 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef RENDERDATASET_H
+#define RENDERDATASET_H
+
+#include "chrtrRenderEngine.hpp"
+
+
+/*!
+  Virtual GDAL dataset whose blocks are rendered by a chrtrRenderEngine when they're read.  This lets the COG
+  driver (which only supports CreateCopy) write a Cloud Optimized GeoTIFF straight from the CHRTR grid without an
+  intermediate GeoTIFF.  The blocks are full width strips that are one render chunk (chrtrRenderEngine::chunkRows)
+  tall.  GDAL reads the bands one at a time so the last strip rendered is kept and the other bands are copied out
+  of it.
+*/
+
+class renderDataset : public GDALDataset
+{
+  friend class renderBand;
+
+public:
+
+  renderDataset (chrtrRenderEngine *eng, int32_t w, int32_t h, int32_t num_bands, uint8_t grey, int32_t strip_rows,
+                 double *trans, const char *wkt, float null);
+  ~renderDataset ();
+
+  CPLErr GetGeoTransform (double *trans);
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,0,0)
+  const OGRSpatialReference *GetSpatialRef () const;
+#else
+  const char *GetProjectionRef ();
+#endif
+
+  void renderStrip (int32_t strip);
+
+
+protected:
+
+  chrtrRenderEngine *engine;
+
+  QMutex           mutex;
+
+#if GDAL_VERSION_NUM >= GDAL_COMPUTE_VERSION(3,0,0)
+  OGRSpatialReference srs;
+#else
+  QByteArray       projection;
+#endif
+
+  double           transform[6];
+
+  int32_t          bands, rows, current_strip;
+
+  float            null_value;
+};
+
+
+
+//!  One band of a renderDataset.
+
+class renderBand : public GDALRasterBand
+{
+public:
+
+  renderBand (renderDataset *ds, int32_t band_num, uint8_t grey, int32_t strip_rows);
+
+  CPLErr IReadBlock (int block_x, int block_y, void *data);
+  double GetNoDataValue (int *success = NULL);
+  GDALColorInterp GetColorInterpretation ();
+
+
+protected:
+
+  uint8_t          is_grey;
+};
+
+#endif
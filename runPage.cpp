@@ -123,3 +123,67 @@ runPage::runPage (QWidget *parent, RUN_PROGRESS *prog, QListWidget **cList):
 
   registerField ("progress_cbar*", progress->cbar, "value");
 }
+
+
+
+runProgress::runProgress (RUN_PROGRESS *prog, QListWidget *cList)
+{
+  progress = prog;
+  checkList = cList;
+}
+
+
+
+QProgressBar *runProgress::bar (int32_t stage)
+{
+  switch (stage)
+    {
+    case RENDER_LOAD_STAGE:
+      return (progress->mbar);
+
+    case RENDER_IMAGE_STAGE:
+      return (progress->gbar);
+    }
+
+  return (progress->cbar);
+}
+
+
+
+void runProgress::stageStart (int32_t stage, int32_t steps)
+{
+  bar (stage)->setRange (0, steps);
+  bar (stage)->setValue (0);
+
+  qApp->processEvents ();
+}
+
+
+
+void runProgress::stageProgress (int32_t stage, int32_t step)
+{
+  //  The contour stage only reports that it's finished.
+
+  if (stage == RENDER_CONTOUR_STAGE)
+    {
+      bar (stage)->setRange (0, 100);
+      bar (stage)->setValue (100);
+    }
+  else
+    {
+      bar (stage)->setValue (step);
+    }
+
+  qApp->processEvents ();
+}
+
+
+
+void runProgress::message (QString string)
+{
+  QListWidgetItem *cur = new QListWidgetItem (string);
+
+  checkList->addItem (cur);
+  checkList->setCurrentItem (cur);
+  checkList->scrollToItem (cur);
+}
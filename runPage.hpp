@@ -40,6 +40,32 @@
 #define RUNPAGE_H
 
 #include "chrtrGeotiff.hpp"
+#include "chrtrRenderEngine.hpp"
+
+
+//!  Progress callbacks for chrtrRenderEngine that update the run page progress bars and checkList.
+
+class runProgress : public renderProgress
+{
+public:
+
+  runProgress (RUN_PROGRESS *prog = NULL, QListWidget *cList = NULL);
+
+  void stageStart (int32_t stage, int32_t steps);
+  void stageProgress (int32_t stage, int32_t step);
+  void message (QString string);
+
+
+protected:
+
+  QProgressBar *bar (int32_t stage);
+
+
+  RUN_PROGRESS     *progress;
+
+  QListWidget      *checkList;
+};
+
 
 
 class runPage:public QWizardPage
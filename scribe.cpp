@@ -43,10 +43,163 @@
 #include <memory.h>
 #include <math.h>
 #include "chrtrGeotiff.hpp"
-#include "shapefil.h"
+#include "contourEngine.hpp"
+#include "contourSink.hpp"
 
-#define         CONTOUR_POINTS          1000
 #define         DEFAULT_SEGMENT_LENGTH  0.25
+#define         ARENA_START_POINTS      4096
+
+
+/*  Point buffers for one contour.  They're reused for every contour and only grow (doubling) when a contour
+    (after smoothing) doesn't fit.  */
+
+typedef struct
+{
+  double          *x, *y, *m;
+  int64_t         size;                     //  Points allocated
+} CONTOUR_ARENA;
+
+
+
+static uint8_t arena_reserve (CONTOUR_ARENA *arena, int64_t points)
+{
+  if (points <= arena->size) return (NVTrue);
+
+
+  int64_t size = qMax ((int64_t) ARENA_START_POINTS, arena->size);
+
+  while (size < points) size *= 2;
+
+
+  double *x = (double *) realloc (arena->x, size * sizeof (double));
+  if (x == NULL) return (NVFalse);
+  arena->x = x;
+
+  double *y = (double *) realloc (arena->y, size * sizeof (double));
+  if (y == NULL) return (NVFalse);
+  arena->y = y;
+
+  double *m = (double *) realloc (arena->m, size * sizeof (double));
+  if (m == NULL) return (NVFalse);
+  arena->m = m;
+
+  arena->size = size;
+
+  return (NVTrue);
+}
+
+
+//  In batch mode there is no QApplication so we can't pop up a message box.
+
+static void scribe_warning (QString message)
+{
+  if (qobject_cast<QApplication *> (QCoreApplication::instance ()))
+    {
+      QMessageBox::warning (0, chrtrGeotiff::tr ("chrtrGeotiff"), message);
+    }
+  else
+    {
+      fprintf (stderr, "%s\n", message.toLatin1 ().constData ());
+    }
+}
+
+
+/*  Writes the lines of each level as contourEngine finishes it.  The points are converted from grid coordinates
+    to positions, smoothed, and written as one object per line.  Closed lines get their first point repeated at
+    the end.  A line with more than CONTOUR_MAX_RECORD_POINTS points is written as several objects that share
+    their end points.  */
+
+class scribeReceiver : public contourReceiver
+{
+public:
+
+  uint8_t levelDone (const contourSet &lines);
+
+
+  contourSink     *writer;
+
+  CONTOUR_ARENA   arena;
+
+  OPTIONS         *options;
+
+  float           xorig, yorig, half_gridx, half_gridy;
+
+  double          x_cell_degrees, y_cell_degrees;
+
+  int32_t         num_interp;
+
+  int64_t         num_contours;
+
+  uint8_t         arena_ok;
+};
+
+
+
+uint8_t scribeReceiver::levelDone (const contourSet &lines)
+{
+  void smooth_contour (int32_t, int32_t *, double *, double *);
+
+
+  //  Smoothing puts num_interp points in place of each segment so, when smoothing, a piece holds fewer raw points
+  //  to keep the smoothed record under CONTOUR_MAX_RECORD_POINTS.
+
+  int64_t piece_max = CONTOUR_MAX_RECORD_POINTS;
+  if (options->smoothing_factor > 0) piece_max = (CONTOUR_MAX_RECORD_POINTS - 1) / num_interp + 1;
+
+
+  for (int64_t line = 0 ; line < lines.count () ; line++)
+    {
+      float level = lines.level[line];
+
+      int64_t count = lines.points (line);
+
+      int64_t total = count + (lines.closed[line] ? 1 : 0);
+
+      if (total < 2) continue;
+
+
+      //  Each piece starts on the last point of the one before it so the line stays connected.
+
+      for (int64_t piece_start = 0 ; piece_start < total - 1 ; piece_start += piece_max - 1)
+        {
+          int32_t num_points = (int32_t) qMin (piece_max, total - piece_start);
+
+          int64_t needed = num_points;
+          if (options->smoothing_factor > 0) needed = (int64_t) num_interp * (num_points - 1) + 1;
+
+          if (!(arena_ok = arena_reserve (&arena, needed))) return (NVFalse);
+
+
+          /*  Convert from grid points (returned contours) to position.  Contours are output as elevations, not
+              depths.  */
+
+          for (int32_t i = 0 ; i < num_points ; i++)
+            {
+              int64_t index = lines.first (line) + (piece_start + i) % count;
+
+              arena.x[i] = xorig + (lines.x[index] * x_cell_degrees) + half_gridx;
+              arena.y[i] = yorig + (lines.y[index] * y_cell_degrees) + half_gridy;
+            }
+
+
+          /* smooth out the contour.  */
+
+          if (options->smoothing_factor > 0) smooth_contour (num_interp, &num_points, arena.x, arena.y);
+
+
+          for (int32_t i = 0 ; i < num_points ; i++) arena.m[i] = (double) level;
+
+
+          if (!writer->addArcM (num_points, arena.x, arena.y, arena.m)) return (NVFalse);
+        }
+
+      num_contours++;
+    }
+
+
+  return (NVTrue);
+}
+
 
 
 /***************************************************************************\
@@ -57,102 +210,80 @@
 *                                                                           *
 *   Date Written:       December 1994                                       *
 *                                                                           *
-*   Purpose:            Get the contours from the contouring package and    *
+*   Purpose:            Get the contours from the contour engine and        *
 *                       draw them.                                          *
 *                                                                           *
 *   Arguments:          ncc     -   number of columns in area               *
 *                       nrr     -   number of rows in area                  *
 *                       xorig   -   origin x (lower left)                   *
 *                       yorig   -   origin y (lower left)                   *
-*                       cntfile -   contour file pointer                    *
+*                       min_z   -   minimum Z value                         *
+*                       max_z   -   maximum Z value                         *
+*                       ar      -   grid array                              *
+*                       null_value - grid values >= this are null           *
+*                       name    -   output file name                        *
+*                       options -   options                                 *
+*                       x_cell_degrees - cell width in degrees              *
+*                       y_cell_degrees - cell height in degrees             *
 *                                                                           *
-*   Return Value:       None                                                *
+*   Return Value:       Number of contour lines, -1 on error                *
 *                                                                           *
 *   Calling Routines:   displaygrid                                         *
 *                                                                           * 
 \***************************************************************************/
 
-int32_t scribe (int32_t num_cols, int32_t num_rows, float xorig, float yorig, float min_z, float max_z, float *ar,
-                char *name, OPTIONS *options, double x_cell_degrees, double y_cell_degrees)
+int64_t scribe (int32_t num_cols, int32_t num_rows, float xorig, float yorig, float min_z, float max_z, float *ar,
+                float null_value, char *name, OPTIONS *options, double x_cell_degrees, double y_cell_degrees)
 {
-  int32_t                 index_contour, num_points, i, num_interp, bytes, num_contours = 0;
-  double                  *dcontour_x, *dcontour_y, *dcontour_m, ix[2], iy[2], dx, dy, cell_diag_length, segment_length;
-  float                   level, half_gridx, half_gridy, *contour_x, *contour_y;
-  char                    shape_name[512], prj_name[512];
-  FILE                    *prj_fp;
-  SHPHandle               shp_hnd;
-  SHPObject               *shape;
-  DBFHandle               dbf_hnd;  
-
-
-  void contourMinMax (float, float);
-  void contourEmphasis (int32_t);
-  void contourMaxDensity (int32_t);
-  void contourMaxPoints (int32_t);
-  void contourLevels (int32_t, float *);
-  int32_t initContour (float, int32_t, int32_t, float *);
-  int32_t getContour (float *, int32_t *, int32_t *, float *, float *);
-  void smooth_contour (int32_t, int32_t *, double *, double *);
+  int32_t                 num_interp;
+  double                  ix[2], iy[2], dx, dy, cell_diag_length, segment_length;
+  char                    contour_name[512], prj_name[512];
+  FILE                    *prj_fp = NULL;
+  contourSink             *writer;
+  scribeReceiver          receiver;
 
 
 
-  strcpy (shape_name, name);
-  strcpy (&shape_name[strlen (shape_name) - 4], ".shp");
+  strcpy (contour_name, name);
+  strcpy (&contour_name[strlen (contour_name) - 4], contourSink::extension (options->contour_format));
 
 
-  if ((shp_hnd = SHPCreate (shape_name, SHPT_ARCM)) == NULL)
-    {
-      QMessageBox::warning (0, chrtrGeotiff::tr ("chrtrGeotiff"),
-                            chrtrGeotiff::tr ("Unable to create ESRI SHP file ") + QDir::toNativeSeparators (QString (shape_name)) + 
-                            chrtrGeotiff::tr ("  The error message returned was:\n\n") +
-                            QString (strerror (errno)) + 
-                            chrtrGeotiff::tr ("\n\nContours will not be generated."));
-
-      return (0);
-    }
-
+  /*  For a shape file the SHP, SHX, and DBF (with a dummy field so Arc won't barf) files are written through big
+      buffers.  GeoPackage and FlatGeobuf files are written through OGR.  */
 
-  //  Making dummy DBF file so Arc won't barf.
+  writer = contourSink::create (options->contour_format);
 
-  if ((dbf_hnd = DBFCreate (shape_name)) == NULL)
+  if (!writer->open (contour_name))
     {
-      QMessageBox::warning (0, chrtrGeotiff::tr ("chrtrGeotiff"),
-                            chrtrGeotiff::tr ("Unable to create ESRI DBF file ") + QDir::toNativeSeparators (QString (shape_name)) + 
-                            chrtrGeotiff::tr ("  The error message returned was:\n\n") +
-                            QString (strerror (errno)) + 
-                            chrtrGeotiff::tr ("\n\nContours will not be generated."));
+      scribe_warning (writer->errorString () + chrtrGeotiff::tr ("\n\nContours will not be generated."));
 
-      return (0);
+      writer->close ();
+      delete writer;
+      return (-1);
     }
 
 
-  //  Adding a dummy field.
-
-  if (DBFAddField (dbf_hnd, "nada", FTLogical, 1, 0) == -1)
+  if (options->contour_format == CONTOUR_SHAPEFILE)
     {
-      QMessageBox::warning (0, chrtrGeotiff::tr ("chrtrGeotiff"), chrtrGeotiff::tr ("Error adding field to DBF file."));
-      return (0);
-    }
-
-
-  //  Stupid freaking .prj file
+      //  Stupid freaking .prj file
 
-  strcpy (prj_name, QString (shape_name).replace (".shp", ".prj").toLatin1 ());
-  fprintf(stderr,"%s %s %d %s\n",__FILE__,__FUNCTION__,__LINE__,prj_name);
+      strcpy (prj_name, QString (contour_name).replace (".shp", ".prj").toLatin1 ());
 
-  if ((prj_fp = fopen (prj_name, "w")) == NULL)
-    {
-      QMessageBox::warning (0, chrtrGeotiff::tr ("chrtrGeotiff"),
-                            chrtrGeotiff::tr ("Unable to create ESRI PRJ file ") + QDir::toNativeSeparators (QString (prj_name)) + 
-                            chrtrGeotiff::tr ("  The error message returned was:\n\n") +
-                            QString (strerror (errno)) + 
-                            chrtrGeotiff::tr ("\n\nContours will not be generated."));
+      if ((prj_fp = fopen (prj_name, "w")) == NULL)
+        {
+          scribe_warning (chrtrGeotiff::tr ("Unable to create ESRI PRJ file ") + QDir::toNativeSeparators (QString (prj_name)) + 
+                          chrtrGeotiff::tr ("  The error message returned was:\n\n") +
+                          QString (strerror (errno)) + 
+                          chrtrGeotiff::tr ("\n\nContours will not be generated."));
+
+          writer->close ();
+          delete writer;
+          return (-1);
+        }
 
-      return (0);
+      fprintf (prj_fp, "COMPD_CS[\"WGS84 with WGS84E Z\",GEOGCS[\"WGS 84\",DATUM[\"WGS_1984\",SPHEROID[\"WGS 84\",6378137,298.257223563,AUTHORITY[\"EPSG\",\"7030\"]],TOWGS84[0,0,0,0,0,0,0],AUTHORITY[\"EPSG\",\"6326\"]],PRIMEM[\"Greenwich\",0,AUTHORITY[\"EPSG\",\"8901\"]],UNIT[\"degree\",0.01745329251994328,AUTHORITY[\"EPSG\",\"9108\"]],AXIS[\"Lat\",NORTH],AXIS[\"Long\",EAST],AUTHORITY[\"EPSG\",\"4326\"]],VERT_CS[\"ellipsoid Z in meters\",VERT_DATUM[\"Ellipsoid\",2002],UNIT[\"metre\",1],AXIS[\"Z\",UP]]]");
     }
 
-  fprintf (prj_fp, "COMPD_CS[\"WGS84 with WGS84E Z\",GEOGCS[\"WGS 84\",DATUM[\"WGS_1984\",SPHEROID[\"WGS 84\",6378137,298.257223563,AUTHORITY[\"EPSG\",\"7030\"]],TOWGS84[0,0,0,0,0,0,0],AUTHORITY[\"EPSG\",\"6326\"]],PRIMEM[\"Greenwich\",0,AUTHORITY[\"EPSG\",\"8901\"]],UNIT[\"degree\",0.01745329251994328,AUTHORITY[\"EPSG\",\"9108\"]],AXIS[\"Lat\",NORTH],AXIS[\"Long\",EAST],AUTHORITY[\"EPSG\",\"4326\"]],VERT_CS[\"ellipsoid Z in meters\",VERT_DATUM[\"Ellipsoid\",2002],UNIT[\"metre\",1],AXIS[\"Z\",UP]]]");
-
 
   /* Check the smoothing factor range and get the number of interpolation points per unsmoothed contour segment */
 
@@ -182,119 +313,61 @@ int32_t scribe (int32_t num_cols, int32_t num_rows, float xorig, float yorig, fl
     }
 
 
-  /* allocate memory for contour arrays */
-
-  if (options->smoothing_factor > 0)
-    {
-      bytes = (((num_interp * (CONTOUR_POINTS - 1)) + 1) * sizeof (double));
-    }
-  else
-    {
-      bytes = (CONTOUR_POINTS * sizeof (double));
-    }
-
-  if ((contour_x = (float *) malloc (bytes / 2)) == NULL)
-    {
-      perror ("Allocating dcontour_m in scribe.cpp");
-      exit (-1);
-    }
-  if ((contour_y = (float *) malloc (bytes / 2)) == NULL)
-    {
-      perror ("Allocating dcontour_m in scribe.cpp");
-      exit (-1);
-    }
-  if ((dcontour_x = (double *) malloc (bytes)) == NULL)
-    {
-      perror ("Allocating dcontour_m in scribe.cpp");
-      exit (-1);
-    }
-  if ((dcontour_y = (double *) malloc (bytes)) == NULL)
-    {
-      perror ("Allocating dcontour_m in scribe.cpp");
-      exit (-1);
-    }
-  if ((dcontour_m = (double *) malloc (bytes)) == NULL)
-    {
-      perror ("Allocating dcontour_m in scribe.cpp");
-      exit (-1);
-    }
-
+  /*  Compute half of a grid cell in degrees. */
 
-  /*  Set the min and max contours, the index contour interval, the
-      maximum contour density, and the number of points to be returned
-      by the package. */
+  receiver.half_gridx = x_cell_degrees * 0.5;
+  receiver.half_gridy = y_cell_degrees * 0.5;
 
-  contourMinMax (min_z, max_z);
-  contourMaxDensity (options->maxd);
-  contourMaxPoints (CONTOUR_POINTS);
-  contourEmphasis (1);
 
+  receiver.writer = writer;
+  receiver.arena.x = receiver.arena.y = receiver.arena.m = NULL;
+  receiver.arena.size = 0;
+  receiver.options = options;
+  receiver.xorig = xorig;
+  receiver.yorig = yorig;
+  receiver.x_cell_degrees = x_cell_degrees;
+  receiver.y_cell_degrees = y_cell_degrees;
+  receiver.num_interp = num_interp;
+  receiver.num_contours = 0;
+  receiver.arena_ok = NVTrue;
 
-  /*  If the contour interval is set to 0.0 use the user defined levels.  */
-  /*    
-  if (options->cint == 0.0)
-    {
-      contourLevels (options->num_levels, options->contour_levels);
-    }
-  */
 
+  /*  Contour the grid array (arranged 1D) at multiples of the contour interval between the min and max using
+      the same number of threads as the render stage.  Each level is written as soon as it's done.  */
 
-  /*  Pass the grid array (arranged 1D) to the contouring package.    */
+  contourEngine engine;
 
-  initContour (options->cint, num_rows, num_cols, ar);
+  engine.setLevels (min_z, max_z, options->cint);
+  engine.generate (ar, num_cols, num_rows, null_value, options->num_threads, &receiver);
 
 
-  /*  Compute half of a grid cell in degrees. */
-
-  half_gridx = x_cell_degrees * 0.5;
-  half_gridy = y_cell_degrees * 0.5;
+  free (receiver.arena.x);
+  free (receiver.arena.y);
+  free (receiver.arena.m);
 
 
-  /*  Get the contours from the package until all are saved.  */
-
-  while (getContour (&level, &index_contour, &num_points, contour_x, contour_y))
+  if (!receiver.arena_ok)
     {
-      if (num_points > 1)
-        {
-          /*  Convert from grid points (returned contours) to position.  Contours are output as elevations, not depths.  */
-
-          for (i = 0 ; i < num_points ; i++)
-            {
-              dcontour_x[i] = xorig + (contour_x[i] * x_cell_degrees) + half_gridx;
-              dcontour_y[i] = yorig + (contour_y[i] * y_cell_degrees) + half_gridy;
-            }
-
-
-          /* smooth out the contour.  */
-
-          if (options->smoothing_factor > 0) smooth_contour (num_interp, &num_points, dcontour_x, dcontour_y);
-
-
-          for (i = 0 ; i < num_points ; i++) dcontour_m[i] = (double) level;
+      scribe_warning (chrtrGeotiff::tr ("Unable to allocate memory for contour points : ") + QString (strerror (errno)));
 
+      if (prj_fp) fclose (prj_fp);
+      writer->close ();
+      delete writer;
+      return (-1);
+    }
 
-          shape = SHPCreateObject (SHPT_ARCM, -1, 0, NULL, NULL, num_points, dcontour_x, dcontour_y, NULL, dcontour_m);
-          SHPWriteObject (shp_hnd, -1, shape);
-          SHPDestroyObject (shape);
 
-          DBFWriteLogicalAttribute (dbf_hnd, num_contours, 0, '0');
+  if (prj_fp) fclose (prj_fp);
 
-          num_contours++;
-        }
-    }
 
+  uint8_t ok = writer->close ();
 
-  free (contour_x);
-  free (contour_y);
-  free (dcontour_x);
-  free (dcontour_y);
-  free (dcontour_m);
+  if (!ok) scribe_warning (writer->errorString ());
 
+  delete writer;
 
-  SHPClose (shp_hnd);
-  DBFClose (dbf_hnd);  
-  fclose (prj_fp);
+  if (!ok) return (-1);
 
 
-  return (num_contours);
+  return (receiver.num_contours);
 }
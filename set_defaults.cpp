@@ -43,7 +43,16 @@ void set_defaults (OPTIONS *options)
   options->chrtr2 = NVFalse;
   options->transparent = NVFalse;
   options->caris = NVFalse;
+  options->cog = NVFalse;
+  options->codec = CODEC_LZW;
+  options->codec_level = 0;
   options->grey = NVFalse;
+  options->tiled = NVFalse;
+  options->tile_width = 256;
+  options->tile_height = 256;
+  options->overviews = NVFalse;
+  options->ov_color_resampling = OVERVIEW_NEAREST;
+  options->ov_grey_resampling = OVERVIEW_AVERAGE;
   options->restart = NVTrue;
   options->azimuth = 30.0;
   options->elevation  = 30.0;
@@ -54,9 +63,22 @@ void set_defaults (OPTIONS *options)
   options->end_hsv = 240.0;
   options->units = 0;
   options->cint = 0.0;
+  options->contour_format = CONTOUR_SHAPEFILE;
   options->dumb = NVFalse;
   options->elev = NVFalse;
   options->smoothing_factor = 10;
+  options->num_threads = 0;
+  options->compress_threads = 0;
+  options->stream = NVFalse;
+  options->grid_cache = NVFalse;
+  options->stats_index = NVFalse;
+
+#ifdef NVWIN3X
+  options->cache_dir = QString (getenv ("USERPROFILE")) + "/ABE.config/chrtrGeotiffCache";
+#else
+  options->cache_dir = QString (getenv ("HOME")) + "/ABE.config/chrtrGeotiffCache";
+#endif
+
   options->window_x = 0;
   options->window_y = 0;
   options->window_width = 1000;
@@ -0,0 +1,394 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "shapeWriter.hpp"
+
+#include <time.h>
+
+
+//  Bytes in the .shp/.shx header, the .dbf header (with one field descriptor), and a .shx record.
+
+#define         SHP_HEADER_SIZE                 100
+#define         DBF_HEADER_SIZE                 65
+#define         SHX_RECORD_SIZE                 8
+
+
+//  The .shp and .shx offsets and lengths are signed 32 bit counts of 16 bit words but many readers stop at 2GB.
+
+#define         SHP_MAX_FILE_SIZE               2147483647LL
+
+
+//  Store a value in "bytes" bytes at dest in big or little endian order.
+
+static void store (uint8_t *dest, uint64_t value, int32_t bytes, uint8_t big_endian)
+{
+  for (int32_t i = 0 ; i < bytes ; i++)
+    {
+      dest[big_endian ? bytes - 1 - i : i] = (uint8_t) (value & 0xff);
+      value >>= 8;
+    }
+}
+
+
+
+static void store_double (uint8_t *dest, double value)
+{
+  uint64_t bits;
+
+  memcpy (&bits, &value, sizeof (double));
+  store (dest, bits, 8, NVFalse);
+}
+
+
+
+shapeWriter::shapeWriter ()
+{
+  memset (&shp, 0, sizeof (SHAPE_STREAM));
+  memset (&shx, 0, sizeof (SHAPE_STREAM));
+  memset (&dbf, 0, sizeof (SHAPE_STREAM));
+
+  ok = NVFalse;
+  memset (bounds, 0, sizeof (bounds));
+}
+
+
+
+shapeWriter::~shapeWriter ()
+{
+  if (shp.fp || shx.fp || dbf.fp) close ();
+}
+
+
+
+void shapeWriter::setError (QString file, QString what)
+{
+  if (ok) error_string = QString (QObject::tr ("Error writing %1 : %2")).arg (QDir::toNativeSeparators (file)).arg (what);
+
+  ok = NVFalse;
+}
+
+
+
+uint8_t shapeWriter::openStream (SHAPE_STREAM *stream, QString name)
+{
+  if ((stream->fp = fopen (name.toLatin1 (), "wb")) == NULL)
+    {
+      error_string = QString (QObject::tr ("Unable to create ESRI file %1 : %2")).arg (QDir::toNativeSeparators (name)).arg (strerror (errno));
+      return (NVFalse);
+    }
+
+  if ((stream->buffer = (uint8_t *) malloc (SHAPE_BUFFER_SIZE)) == NULL)
+    {
+      error_string = QString (QObject::tr ("Unable to allocate shape file buffer : %1")).arg (strerror (errno));
+      return (NVFalse);
+    }
+
+  stream->used = 0;
+  stream->size = 0;
+
+  return (NVTrue);
+}
+
+
+
+/*!
+  Create the .shp, .shx, and .dbf files for "shape_name" (the .shp file name) and write place holders for the
+  headers.
+*/
+
+uint8_t shapeWriter::open (char *shape_name)
+{
+  base_name = QString (shape_name);
+  if (base_name.endsWith (".shp")) base_name.chop (4);
+
+  num_records = 0;
+  memset (bounds, 0, sizeof (bounds));
+  error_string = "";
+
+  if (!openStream (&shp, base_name + ".shp") || !openStream (&shx, base_name + ".shx") || !openStream (&dbf, base_name + ".dbf"))
+    {
+      closeStream (&shp);
+      closeStream (&shx);
+      closeStream (&dbf);
+      return (NVFalse);
+    }
+
+  ok = NVTrue;
+
+
+  uint8_t header[SHP_HEADER_SIZE];
+
+  memset (header, 0, SHP_HEADER_SIZE);
+  put (&shp, header, SHP_HEADER_SIZE);
+  put (&shx, header, SHP_HEADER_SIZE);
+  put (&dbf, header, DBF_HEADER_SIZE);
+
+  return (ok);
+}
+
+
+
+//!  Flush the buffer to the file.
+
+void shapeWriter::flush (SHAPE_STREAM *stream)
+{
+  if (ok && stream->used && fwrite (stream->buffer, 1, stream->used, stream->fp) != (size_t) stream->used)
+    {
+      setError (base_name, QString (strerror (errno)));
+    }
+
+  stream->used = 0;
+}
+
+
+
+//!  Append bytes to the stream, writing the buffer out whenever it fills up.
+
+void shapeWriter::put (SHAPE_STREAM *stream, const void *data, int32_t bytes)
+{
+  const uint8_t *src = (const uint8_t *) data;
+
+  stream->size += bytes;
+
+  while (bytes)
+    {
+      int32_t count = qMin (bytes, SHAPE_BUFFER_SIZE - stream->used);
+
+      memcpy (&stream->buffer[stream->used], src, count);
+      stream->used += count;
+      src += count;
+      bytes -= count;
+
+      if (stream->used == SHAPE_BUFFER_SIZE) flush (stream);
+    }
+}
+
+
+
+void shapeWriter::putInt (SHAPE_STREAM *stream, int32_t value, uint8_t big_endian)
+{
+  uint8_t bytes[4];
+
+  store (bytes, (uint32_t) value, 4, big_endian);
+  put (stream, bytes, 4);
+}
+
+
+
+void shapeWriter::putDouble (SHAPE_STREAM *stream, double value)
+{
+  uint8_t bytes[8];
+
+  store_double (bytes, value);
+  put (stream, bytes, 8);
+}
+
+
+
+/*!
+  Add a PolyLineM record with one part of "count" points (and its .shx index entry and .dbf row).
+*/
+
+uint8_t shapeWriter::addArcM (int32_t count, double *x, double *y, double *m)
+{
+  if (!ok) return (NVFalse);
+
+
+  //  Shape type, box, number of parts, number of points, part start, points, M range, M values.
+
+  int64_t content = 4 + 32 + 4 + 4 + 4 + (int64_t) count * 16 + 16 + (int64_t) count * 8;
+
+  if (count > CONTOUR_MAX_RECORD_POINTS || shp.size + 8 + content > SHP_MAX_FILE_SIZE)
+    {
+      setError (base_name + ".shp", QObject::tr ("the shape file would be bigger than 2GB, use GeoPackage or FlatGeobuf"));
+      return (NVFalse);
+    }
+
+
+  double box[6] = {x[0], y[0], x[0], y[0], m[0], m[0]};
+
+  for (int32_t i = 1 ; i < count ; i++)
+    {
+      box[0] = qMin (box[0], x[i]);
+      box[1] = qMin (box[1], y[i]);
+      box[2] = qMax (box[2], x[i]);
+      box[3] = qMax (box[3], y[i]);
+      box[4] = qMin (box[4], m[i]);
+      box[5] = qMax (box[5], m[i]);
+    }
+
+  if (!num_records)
+    {
+      memcpy (bounds, box, sizeof (bounds));
+    }
+  else
+    {
+      bounds[0] = qMin (bounds[0], box[0]);
+      bounds[1] = qMin (bounds[1], box[1]);
+      bounds[2] = qMax (bounds[2], box[2]);
+      bounds[3] = qMax (bounds[3], box[3]);
+      bounds[4] = qMin (bounds[4], box[4]);
+      bounds[5] = qMax (bounds[5], box[5]);
+    }
+
+
+  putInt (&shx, (int32_t) (shp.size / 2), NVTrue);
+  putInt (&shx, (int32_t) (content / 2), NVTrue);
+
+  putInt (&shp, num_records + 1, NVTrue);
+  putInt (&shp, (int32_t) (content / 2), NVTrue);
+  putInt (&shp, SHPT_ARCM, NVFalse);
+  for (int32_t i = 0 ; i < 4 ; i++) putDouble (&shp, box[i]);
+  putInt (&shp, 1, NVFalse);
+  putInt (&shp, count, NVFalse);
+  putInt (&shp, 0, NVFalse);
+
+  for (int32_t i = 0 ; i < count ; i++)
+    {
+      putDouble (&shp, x[i]);
+      putDouble (&shp, y[i]);
+    }
+
+  putDouble (&shp, box[4]);
+  putDouble (&shp, box[5]);
+  for (int32_t i = 0 ; i < count ; i++) putDouble (&shp, m[i]);
+
+
+  //  Not deleted, and the dummy field.
+
+  put (&dbf, " 0", 2);
+
+
+  num_records++;
+
+  return (ok);
+}
+
+
+
+//!  Build the .shp/.shx header for a file of file_size bytes.
+
+void shapeWriter::shapeHeader (uint8_t *header, int64_t file_size)
+{
+  memset (header, 0, SHP_HEADER_SIZE);
+
+  store (header, 9994, 4, NVTrue);
+  store (&header[24], (uint64_t) (file_size / 2), 4, NVTrue);
+  store (&header[28], 1000, 4, NVFalse);
+  store (&header[32], SHPT_ARCM, 4, NVFalse);
+
+  for (int32_t i = 0 ; i < 4 ; i++) store_double (&header[36 + i * 8], bounds[i]);
+
+  store_double (&header[84], bounds[4]);
+  store_double (&header[92], bounds[5]);
+}
+
+
+
+//!  Overwrite the start of the file with the real header.
+
+void shapeWriter::writeHeader (SHAPE_STREAM *stream, const uint8_t *header, int32_t bytes)
+{
+  flush (stream);
+
+  if (ok && (fseek (stream->fp, 0, SEEK_SET) || fwrite (header, 1, bytes, stream->fp) != (size_t) bytes))
+    {
+      setError (base_name, QString (strerror (errno)));
+    }
+}
+
+
+
+void shapeWriter::closeStream (SHAPE_STREAM *stream)
+{
+  if (stream->fp && fclose (stream->fp)) setError (base_name, QString (strerror (errno)));
+  stream->fp = NULL;
+
+  if (stream->buffer) free (stream->buffer);
+  stream->buffer = NULL;
+}
+
+
+
+//!  Write the buffers, fill in the headers, and close the files.
+
+uint8_t shapeWriter::close ()
+{
+  uint8_t header[SHP_HEADER_SIZE];
+
+
+  if (shp.fp && shx.fp && dbf.fp)
+    {
+      shapeHeader (header, shp.size);
+      writeHeader (&shp, header, SHP_HEADER_SIZE);
+
+      shapeHeader (header, shx.size);
+      writeHeader (&shx, header, SHP_HEADER_SIZE);
+
+
+      //  dBASE III header with one one byte logical field ("nada") followed by the end of file marker.
+
+      uint8_t eof = 0x1a;
+      put (&dbf, &eof, 1);
+
+      time_t now = time (NULL);
+      struct tm *today = localtime (&now);
+
+      memset (header, 0, DBF_HEADER_SIZE);
+      header[0] = 0x03;
+      header[1] = (uint8_t) today->tm_year;
+      header[2] = (uint8_t) (today->tm_mon + 1);
+      header[3] = (uint8_t) today->tm_mday;
+      store (&header[4], num_records, 4, NVFalse);
+      store (&header[8], DBF_HEADER_SIZE, 2, NVFalse);
+      store (&header[10], 2, 2, NVFalse);
+      strcpy ((char *) &header[32], "nada");
+      header[43] = 'L';
+      header[48] = 1;
+      header[64] = 0x0d;
+
+      writeHeader (&dbf, header, DBF_HEADER_SIZE);
+    }
+
+
+  closeStream (&shp);
+  closeStream (&shx);
+  closeStream (&dbf);
+
+  return (ok);
+}
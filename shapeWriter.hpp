@@ -0,0 +1,104 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef SHAPEWRITER_H
+#define SHAPEWRITER_H
+
+#include "contourSink.hpp"
+
+
+//  Size of the memory buffer for each of the .shp, .shx, and .dbf files.
+
+#define         SHAPE_BUFFER_SIZE               (4 * 1024 * 1024)
+
+
+//  One output file and its buffer.
+
+typedef struct
+{
+  FILE             *fp;
+  uint8_t          *buffer;
+  int32_t          used;                    //  Bytes in the buffer
+  int64_t          size;                    //  Bytes written to the file so far, including the buffer
+} SHAPE_STREAM;
+
+
+/*!
+  Writer for ESRI PolyLineM (SHPT_ARCM) shape files with the dummy "nada" logical DBF field that Arc wants.  The
+  .shp, .shx, and .dbf records are built in SHAPE_BUFFER_SIZE memory buffers and written sequentially when a
+  buffer fills instead of having shapelib seek and write each piece of each record.  The headers are written as
+  place holders when the files are opened and filled in (file lengths, bounds, and record count) by close.
+
+  Once there has been an error nothing else is written.
+*/
+
+class shapeWriter : public contourSink
+{
+public:
+
+  shapeWriter ();
+  ~shapeWriter ();
+
+  uint8_t open (char *shape_name);
+  uint8_t addArcM (int32_t count, double *x, double *y, double *m);
+  uint8_t close ();
+
+
+protected:
+
+  uint8_t openStream (SHAPE_STREAM *stream, QString name);
+  void put (SHAPE_STREAM *stream, const void *data, int32_t bytes);
+  void putInt (SHAPE_STREAM *stream, int32_t value, uint8_t big_endian);
+  void putDouble (SHAPE_STREAM *stream, double value);
+  void flush (SHAPE_STREAM *stream);
+  void writeHeader (SHAPE_STREAM *stream, const uint8_t *header, int32_t bytes);
+  void closeStream (SHAPE_STREAM *stream);
+  void shapeHeader (uint8_t *header, int64_t file_size);
+  void setError (QString file, QString what);
+
+
+  SHAPE_STREAM     shp, shx, dbf;
+
+  QString          base_name;
+
+  uint8_t          ok;
+
+  double           bounds[6];               //  X min, Y min, X max, Y max, M min, M max
+};
+
+#endif
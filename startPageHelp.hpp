@@ -60,8 +60,10 @@ QString area_fileText =
                  "format (.are), the Army Corps area format (.afs), or ESRI shape file format.  Shape files must be "
                  "either Polygon, PolygonZ, PolygonM, PolyLine, PolyLineZ, or PolyLineM format and must be geographic "
                  "(not projected).  For PolyLine files the first point will be duplicated to close the polygon.  "
-                 "Whether using Polygon or PolyLine files, only the first shape will be used if there are multiple "
-                 "shapes in the file.<br><br>"
+                 "Whether using Polygon or PolyLine files, all of the shapes in the file, and all of the parts of each "
+                 "shape, will be used.  Parts inside of other parts of the same shape are holes.<br><br>"
+                 "Only the cells whose centers are inside of the polygon(s) will be shaded, colored, and contoured.  The "
+                 "rest of the area file's bounding rectangle will be empty.<br><br>"
                  "Generic area format files (.are) contain a simple list of polygon points.  The points may be in any of the "
                  "following formats:"
                  "<ul>"
@@ -0,0 +1,301 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "statsIndex.hpp"
+
+#include <sys/stat.h>
+
+
+//  Written into the header in the native byte order so a file from a machine with the other byte order isn't used.
+
+#define         STATS_INDEX_BYTE_ORDER          0x01020304
+
+
+statsIndex::statsIndex ()
+{
+  width = height = blocks_x = blocks_y = 0;
+  source_mtime = source_size = 0;
+}
+
+
+
+void statsIndex::clear ()
+{
+  blocks.clear ();
+  width = height = blocks_x = blocks_y = 0;
+  source_mtime = source_size = 0;
+}
+
+
+
+//!  Set the index file name, the block layout, and the CHRTR file's modification time and size.
+
+void statsIndex::setSource (char *chrtr_name, int32_t cols, int32_t rows)
+{
+  struct stat st;
+
+
+  path = QString (chrtr_name) + ".stats";
+
+  width = cols;
+  height = rows;
+  blocks_x = (cols + STATS_BLOCK_SIZE - 1) / STATS_BLOCK_SIZE;
+  blocks_y = (rows + STATS_BLOCK_SIZE - 1) / STATS_BLOCK_SIZE;
+
+  source_mtime = source_size = 0;
+  if (!stat (chrtr_name, &st))
+    {
+      source_mtime = (int64_t) st.st_mtime;
+      source_size = (int64_t) st.st_size;
+    }
+}
+
+
+
+/*!
+  Histogram bin for Z.  Bins 16 and up are the octaves at or above zero (0 to 1, 1 to 3, 3 to 7, ...), bins 15 and
+  down are the same octaves below zero.  The first and last bins hold everything beyond them.
+*/
+
+int32_t statsIndex::bin (float z)
+{
+  int32_t half = STATS_HISTOGRAM_BINS / 2;
+  int32_t octave = 0;
+  double a = fabs ((double) z) + 1.0;
+
+  while (octave < half - 1 && a >= 2.0)
+    {
+      a *= 0.5;
+      octave++;
+    }
+
+  if (z < 0.0) return (half - 1 - octave);
+
+  return (half + octave);
+}
+
+
+
+void statsIndex::init (STATS_BLOCK *stats)
+{
+  memset (stats, 0, sizeof (STATS_BLOCK));
+}
+
+
+
+//!  Add a valid Z value to stats.
+
+void statsIndex::addValue (STATS_BLOCK *stats, float z)
+{
+  if (stats->count)
+    {
+      stats->min_z = qMin (stats->min_z, z);
+      stats->max_z = qMax (stats->max_z, z);
+    }
+  else
+    {
+      stats->min_z = stats->max_z = z;
+    }
+
+  stats->count++;
+  stats->sum += z;
+  stats->histogram[bin (z)]++;
+}
+
+
+
+//!  Add the statistics in "other" to stats.
+
+void statsIndex::combine (STATS_BLOCK *stats, const STATS_BLOCK *other)
+{
+  if (!other->count) return;
+
+
+  if (stats->count)
+    {
+      stats->min_z = qMin (stats->min_z, other->min_z);
+      stats->max_z = qMax (stats->max_z, other->max_z);
+    }
+  else
+    {
+      stats->min_z = other->min_z;
+      stats->max_z = other->max_z;
+    }
+
+  stats->count += other->count;
+  stats->sum += other->sum;
+
+  for (int32_t i = 0 ; i < STATS_HISTOGRAM_BINS ; i++) stats->histogram[i] += other->histogram[i];
+}
+
+
+
+/*!
+  Read the index for a cols by rows CHRTR file.  Returns 0 if there is an up to date index for the file or -1 if
+  there isn't (in which case it can be built with start, addRow, and write).
+*/
+
+int32_t statsIndex::read (char *chrtr_name, int32_t cols, int32_t rows)
+{
+  STATS_INDEX_HEADER header;
+
+
+  clear ();
+
+  setSource (chrtr_name, cols, rows);
+
+
+  FILE *fp = fopen (path.toLatin1 (), "rb");
+  if (fp == NULL) return (-1);
+
+  if (fread (&header, sizeof (STATS_INDEX_HEADER), 1, fp) != 1 || strncmp (header.magic, "CHRTRSI", 8) ||
+      header.byte_order != STATS_INDEX_BYTE_ORDER || header.version != STATS_INDEX_VERSION || header.width != width ||
+      header.height != height || header.block_size != STATS_BLOCK_SIZE || header.bins != STATS_HISTOGRAM_BINS ||
+      header.source_mtime != source_mtime || header.source_size != source_size)
+    {
+      fclose (fp);
+      return (-1);
+    }
+
+
+  blocks.resize (blocks_x * blocks_y);
+
+  if (fread (blocks.data (), sizeof (STATS_BLOCK), blocks.size (), fp) != (size_t) blocks.size ())
+    {
+      blocks.clear ();
+      fclose (fp);
+      return (-1);
+    }
+
+  fclose (fp);
+
+
+  return (0);
+}
+
+
+
+//!  Start building the index for the file passed to read.  Every row then has to be passed to addRow.
+
+void statsIndex::start ()
+{
+  STATS_BLOCK empty;
+  init (&empty);
+
+  blocks.fill (empty, blocks_x * blocks_y);
+}
+
+
+
+//!  Add row "row" (0 is the southernmost row) of the CHRTR file, as read, to the blocks it falls in.
+
+void statsIndex::addRow (int32_t row, float *data, float null_value)
+{
+  STATS_BLOCK *row_blocks = &blocks[(row / STATS_BLOCK_SIZE) * blocks_x];
+
+
+  for (int32_t bx = 0 ; bx < blocks_x ; bx++)
+    {
+      int32_t end = qMin (width, (bx + 1) * STATS_BLOCK_SIZE);
+
+      for (int32_t j = bx * STATS_BLOCK_SIZE ; j < end ; j++)
+        {
+          if (data[j] < null_value) addValue (&row_blocks[bx], data[j]);
+        }
+    }
+}
+
+
+
+//!  Write the index file.  It's written under a temporary name and renamed so a partial index is never used.
+
+int32_t statsIndex::write ()
+{
+  STATS_INDEX_HEADER header;
+
+
+  memset (&header, 0, sizeof (STATS_INDEX_HEADER));
+
+  strcpy (header.magic, "CHRTRSI");
+  header.byte_order = STATS_INDEX_BYTE_ORDER;
+  header.version = STATS_INDEX_VERSION;
+  header.width = width;
+  header.height = height;
+  header.block_size = STATS_BLOCK_SIZE;
+  header.bins = STATS_HISTOGRAM_BINS;
+  header.source_mtime = source_mtime;
+  header.source_size = source_size;
+
+  init (&header.file);
+  for (int32_t i = 0 ; i < blocks.size () ; i++) combine (&header.file, &blocks[i]);
+
+
+  QString temp_path = path + QString (".%1.tmp").arg ((qlonglong) QCoreApplication::applicationPid ());
+
+  FILE *fp = fopen (temp_path.toLatin1 (), "wb");
+  if (fp == NULL)
+    {
+      error_string = QObject::tr ("Unable to create statistics index %1 : %2").arg (temp_path).arg (QString (strerror (errno)));
+      return (-1);
+    }
+
+  int32_t status = (fwrite (&header, sizeof (STATS_INDEX_HEADER), 1, fp) != 1 ||
+                    fwrite (blocks.constData (), sizeof (STATS_BLOCK), blocks.size (), fp) != (size_t) blocks.size ());
+
+  if (fclose (fp)) status = 1;
+
+  if (status)
+    {
+      error_string = QObject::tr ("Unable to write statistics index %1 : %2").arg (temp_path).arg (QString (strerror (errno)));
+      QFile::remove (temp_path);
+      return (-1);
+    }
+
+
+  QFile::remove (path);
+
+  if (!QFile::rename (temp_path, path))
+    {
+      error_string = QObject::tr ("Unable to rename %1 to %2").arg (temp_path).arg (path);
+      QFile::remove (temp_path);
+      return (-1);
+    }
+
+
+  return (0);
+}
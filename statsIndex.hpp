@@ -0,0 +1,142 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#ifndef STATSINDEX_H
+#define STATSINDEX_H
+
+#include "chrtrGeotiffDef.hpp"
+
+
+//  Width and height, in grid cells, of the statistics blocks.
+
+#define         STATS_BLOCK_SIZE                256
+
+
+//  Number of histogram bins (see statsIndex::bin).
+
+#define         STATS_HISTOGRAM_BINS            32
+
+
+//  Bump this if the index file layout changes.
+
+#define         STATS_INDEX_VERSION             1
+
+
+//  Statistics for a block (or a file, or a window) of Z values as read from the CHRTR file (before any units or
+//  depth/elevation conversion).
+
+typedef struct
+{
+  float         min_z;
+  float         max_z;
+  int64_t       count;                      //  Number of valid cells (min_z and max_z aren't set if this is 0)
+  double        sum;
+  uint32_t      histogram[STATS_HISTOGRAM_BINS];
+} STATS_BLOCK;
+
+
+//  Index file header.  The blocks follow, blocks_x per row of blocks, south row of blocks first.
+
+typedef struct
+{
+  char          magic[8];                   //  "CHRTRSI" and a NULL
+  uint32_t      byte_order;                 //  0x01020304 written in the native byte order
+  int32_t       version;                    //  STATS_INDEX_VERSION
+  int32_t       width;
+  int32_t       height;
+  int32_t       block_size;                 //  STATS_BLOCK_SIZE
+  int32_t       bins;                       //  STATS_HISTOGRAM_BINS
+  int64_t       source_mtime;               //  Modification time of the CHRTR file when the index was built
+  int64_t       source_size;                //  Size of the CHRTR file when the index was built
+  STATS_BLOCK   file;                       //  Statistics for the whole file
+} STATS_INDEX_HEADER;
+
+
+/*!
+  Statistics index for a CHRTR/CHRTR2 file.  The file is split into STATS_BLOCK_SIZE square blocks (rows and
+  columns counted from the southwest corner) and the min, max, count, sum, and a coarse histogram of the valid
+  cells in each block are saved in an index file next to the CHRTR file (the CHRTR file name with .stats added).
+  Since block statistics can be combined, the statistics for any window can be put together from the blocks that
+  are entirely inside of it plus the cells of the blocks along its edges (see chrtrRenderEngine::indexStats).
+
+  The histogram bins are signed octaves of Z (0 to 1, 1 to 3, 3 to 7, ... on either side of zero) so they are the
+  same for every block and every file.  The index is only used if the CHRTR file's modification time and size
+  haven't changed since it was built.
+*/
+
+class statsIndex
+{
+public:
+
+  statsIndex ();
+
+  void clear ();
+  int32_t read (char *chrtr_name, int32_t cols, int32_t rows);
+  void start ();
+  void addRow (int32_t row, float *data, float null_value);
+  int32_t write ();
+
+  uint8_t valid () {return (!blocks.isEmpty ());};
+  int32_t blocksX () {return (blocks_x);};
+  int32_t blocksY () {return (blocks_y);};
+  const STATS_BLOCK *block (int32_t bx, int32_t by) {return (&blocks[by * blocks_x + bx]);};
+  QString fileName () {return (path);};
+  QString errorString () {return (error_string);};
+
+  static int32_t bin (float z);
+  static void init (STATS_BLOCK *stats);
+  static void addValue (STATS_BLOCK *stats, float z);
+  static void combine (STATS_BLOCK *stats, const STATS_BLOCK *other);
+
+
+protected:
+
+  void setSource (char *chrtr_name, int32_t cols, int32_t rows);
+
+
+  QVector<STATS_BLOCK> blocks;
+
+  QString          path, error_string;
+
+  int32_t          width, height, blocks_x, blocks_y;
+
+  int64_t          source_mtime, source_size;
+};
+
+
+#endif
@@ -0,0 +1,314 @@
+
+/*********************************************************************************************
+
+    This is public domain software that was developed by or for the U.S. Naval Oceanographic
+    Office and/or the U.S. Army Corps of Engineers.
+
+    This is a work of the U.S. Government. In accordance with 17 USC 105, copyright protection
+    is not available for any work of the U.S. Government.
+
+    Neither the United States Government, nor any employees of the United States Government,
+    nor the author, makes any warranty, express or implied, without even the implied warranty
+    of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE, or assumes any liability or
+    responsibility for the accuracy, completeness, or usefulness of any information,
+    apparatus, product, or process disclosed, or represents that its use would not infringe
+    privately-owned rights. Reference herein to any specific commercial products, process,
+    or service by trade name, trademark, manufacturer, or otherwise, does not necessarily
+    constitute or imply its endorsement, recommendation, or favoring by the United States
+    Government. The views and opinions of authors expressed herein do not necessarily state
+    or reflect those of the United States Government, and shall not be used for advertising
+    or product endorsement purposes.
+*********************************************************************************************/
+
+
+/****************************************  IMPORTANT NOTE  **********************************
+
+    Comments in this file that start with / * ! or / / ! are being used by Doxygen to
+    document the software.  Dashes in these comment blocks are used to create bullet lists.
+    The lack of blank lines after a block of dash preceeded comments means that the next
+    block of dash preceeded comments is a new, indented bullet list.  I've tried to keep the
+    Doxygen formatting to a minimum but there are some other items (like <br> and <pre>)
+    that need to be left alone.  If you see a comment that starts with / * ! or / / ! and
+    there is something that looks a bit weird it is probably due to some arcane Doxygen
+    syntax.  Be very careful modifying blocks of Doxygen comments.
+
+*****************************************  IMPORTANT NOTE  **********************************/
+
+
+
+#include "chrtrGeotiffDef.hpp"
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define SUNSHADE_ROW_X86
+#include <immintrin.h>
+#endif
+
+
+//  Never fuse a multiply and an add in this file (see SHADE_CONST).  The build also uses -ffp-contract=off.
+
+#if defined (__GNUC__) && !defined (__clang__)
+#pragma GCC optimize ("fp-contract=off")
+#endif
+
+
+/*
+  Sunshade arithmetic shared by the scalar and SIMD versions of sunshade_row.  The surface normal of a cell comes from
+  the cross product of the two cell edge vectors (x_cell_size, 0, dz_x) and (0, y_cell_size, dz_y), where dz_x is the
+  exaggerated change in Z to the next column and dz_y is the exaggerated change in Z to the adjacent row.  The shade
+  is the cosine of the angle between the normal and the sun vector (from sun_unv).  This is what sunshade in
+  nvutility does except that it's done in single precision.  Like nvutility, null neighbors aren't special, they
+  just produce a very steep slope.
+
+  Every version does exactly the same operations in the same order (no fused multiply-adds, the build turns off
+  floating point contraction with -ffp-contract=off) and add, subtract, multiply, divide, and square root are all
+  correctly rounded so the factors are the same bits no matter which version shaded a cell or what CPU it ran on.
+  clang only contracts within a single expression and the SIMD versions are written one operation per intrinsic.
+  The negated normal components (nx, ny) are used so the dot product is sun_nz - nx * sun_x - ny * sun_y.
+*/
+
+typedef struct
+{
+  float         exag;
+  float         dx;                 //  x_cell_size
+  float         dy;                 //  y_cell_size
+  float         nz2;                //  Square of the Z component of the normal (x_cell_size * y_cell_size)
+  float         sun_x;
+  float         sun_y;
+  float         sun_nz;             //  Z component of the normal times the Z component of the sun vector
+  float         min_shade;
+  float         null_value;
+} SHADE_CONST;
+
+
+
+static inline float shade_one (float z, float z_x, float z_y, SHADE_CONST *sc)
+{
+  float dz_x, dz_y, nx, ny, cosine;
+
+
+  //  A null cell can't be shaded (it won't be colored anyway).
+
+  if (z >= sc->null_value) return (sc->min_shade);
+
+  dz_x = (z_x - z) * sc->exag;
+  dz_y = (z_y - z) * sc->exag;
+
+  nx = dz_x * sc->dy;
+  ny = dz_y * sc->dx;
+
+  cosine = ((sc->sun_nz - nx * sc->sun_x) - ny * sc->sun_y) / sqrtf ((nx * nx + ny * ny) + sc->nz2);
+
+
+  //  Negative (or, with a huge null neighbor, NaN) means the cell faces away from the sun.
+
+  if (!(cosine >= 0.0f)) return (sc->min_shade);
+
+  return (cosine);
+}
+
+
+
+#ifdef SUNSHADE_ROW_X86
+
+//  Sixteen cells at a time.  Returns the index of the first cell that wasn't done.
+
+__attribute__ ((target ("avx512f")))
+static int32_t shade_avx512 (float *lower_row, float *upper_row, int32_t count, SHADE_CONST *sc, float *shade)
+{
+  int32_t j;
+  __m512 exag = _mm512_set1_ps (sc->exag), dx = _mm512_set1_ps (sc->dx), dy = _mm512_set1_ps (sc->dy);
+  __m512 nz2 = _mm512_set1_ps (sc->nz2), sun_x = _mm512_set1_ps (sc->sun_x), sun_y = _mm512_set1_ps (sc->sun_y);
+  __m512 sun_nz = _mm512_set1_ps (sc->sun_nz), min_shade = _mm512_set1_ps (sc->min_shade);
+  __m512 null = _mm512_set1_ps (sc->null_value), zero = _mm512_setzero_ps ();
+
+
+  for (j = 0 ; j + 16 <= count ; j += 16)
+    {
+      __m512 z = _mm512_loadu_ps (&upper_row[j]);
+      __m512 z_x = _mm512_loadu_ps (&upper_row[j + 1]);
+      __m512 z_y = _mm512_loadu_ps (&lower_row[j]);
+
+      __m512 nx = _mm512_mul_ps (_mm512_mul_ps (_mm512_sub_ps (z_x, z), exag), dy);
+      __m512 ny = _mm512_mul_ps (_mm512_mul_ps (_mm512_sub_ps (z_y, z), exag), dx);
+
+      __m512 dot = _mm512_sub_ps (_mm512_sub_ps (sun_nz, _mm512_mul_ps (nx, sun_x)), _mm512_mul_ps (ny, sun_y));
+
+
+      //  maskz with all lanes set is plain sqrt, it just keeps gcc 12's uninitialized warning for _mm512_sqrt_ps quiet.
+
+      __m512 len = _mm512_maskz_sqrt_ps (0xffff, _mm512_add_ps (_mm512_add_ps (_mm512_mul_ps (nx, nx), _mm512_mul_ps (ny, ny)),
+                                                                nz2));
+      __m512 cosine = _mm512_div_ps (dot, len);
+
+      __mmask16 bad = _mm512_cmp_ps_mask (cosine, zero, _CMP_NGE_UQ) | _mm512_cmp_ps_mask (z, null, _CMP_GE_OQ);
+
+      _mm512_storeu_ps (&shade[j], _mm512_mask_blend_ps (bad, cosine, min_shade));
+    }
+
+  return (j);
+}
+
+
+
+//  Eight cells at a time.  Returns the index of the first cell that wasn't done.
+
+__attribute__ ((target ("avx2")))
+static int32_t shade_avx2 (float *lower_row, float *upper_row, int32_t count, SHADE_CONST *sc, float *shade)
+{
+  int32_t j;
+  __m256 exag = _mm256_set1_ps (sc->exag), dx = _mm256_set1_ps (sc->dx), dy = _mm256_set1_ps (sc->dy);
+  __m256 nz2 = _mm256_set1_ps (sc->nz2), sun_x = _mm256_set1_ps (sc->sun_x), sun_y = _mm256_set1_ps (sc->sun_y);
+  __m256 sun_nz = _mm256_set1_ps (sc->sun_nz), min_shade = _mm256_set1_ps (sc->min_shade);
+  __m256 null = _mm256_set1_ps (sc->null_value), zero = _mm256_setzero_ps ();
+
+
+  for (j = 0 ; j + 8 <= count ; j += 8)
+    {
+      __m256 z = _mm256_loadu_ps (&upper_row[j]);
+      __m256 z_x = _mm256_loadu_ps (&upper_row[j + 1]);
+      __m256 z_y = _mm256_loadu_ps (&lower_row[j]);
+
+      __m256 nx = _mm256_mul_ps (_mm256_mul_ps (_mm256_sub_ps (z_x, z), exag), dy);
+      __m256 ny = _mm256_mul_ps (_mm256_mul_ps (_mm256_sub_ps (z_y, z), exag), dx);
+
+      __m256 dot = _mm256_sub_ps (_mm256_sub_ps (sun_nz, _mm256_mul_ps (nx, sun_x)), _mm256_mul_ps (ny, sun_y));
+      __m256 len = _mm256_sqrt_ps (_mm256_add_ps (_mm256_add_ps (_mm256_mul_ps (nx, nx), _mm256_mul_ps (ny, ny)), nz2));
+      __m256 cosine = _mm256_div_ps (dot, len);
+
+      __m256 bad = _mm256_or_ps (_mm256_cmp_ps (cosine, zero, _CMP_NGE_UQ), _mm256_cmp_ps (z, null, _CMP_GE_OQ));
+
+      _mm256_storeu_ps (&shade[j], _mm256_blendv_ps (cosine, min_shade, bad));
+    }
+
+  return (j);
+}
+
+
+
+//  Four cells at a time.  Returns the index of the first cell that wasn't done.
+
+__attribute__ ((target ("sse4.1")))
+static int32_t shade_sse4 (float *lower_row, float *upper_row, int32_t count, SHADE_CONST *sc, float *shade)
+{
+  int32_t j;
+  __m128 exag = _mm_set1_ps (sc->exag), dx = _mm_set1_ps (sc->dx), dy = _mm_set1_ps (sc->dy);
+  __m128 nz2 = _mm_set1_ps (sc->nz2), sun_x = _mm_set1_ps (sc->sun_x), sun_y = _mm_set1_ps (sc->sun_y);
+  __m128 sun_nz = _mm_set1_ps (sc->sun_nz), min_shade = _mm_set1_ps (sc->min_shade);
+  __m128 null = _mm_set1_ps (sc->null_value), zero = _mm_setzero_ps ();
+
+
+  for (j = 0 ; j + 4 <= count ; j += 4)
+    {
+      __m128 z = _mm_loadu_ps (&upper_row[j]);
+      __m128 z_x = _mm_loadu_ps (&upper_row[j + 1]);
+      __m128 z_y = _mm_loadu_ps (&lower_row[j]);
+
+      __m128 nx = _mm_mul_ps (_mm_mul_ps (_mm_sub_ps (z_x, z), exag), dy);
+      __m128 ny = _mm_mul_ps (_mm_mul_ps (_mm_sub_ps (z_y, z), exag), dx);
+
+      __m128 dot = _mm_sub_ps (_mm_sub_ps (sun_nz, _mm_mul_ps (nx, sun_x)), _mm_mul_ps (ny, sun_y));
+      __m128 len = _mm_sqrt_ps (_mm_add_ps (_mm_add_ps (_mm_mul_ps (nx, nx), _mm_mul_ps (ny, ny)), nz2));
+      __m128 cosine = _mm_div_ps (dot, len);
+
+      __m128 bad = _mm_or_ps (_mm_cmpnge_ps (cosine, zero), _mm_cmpge_ps (z, null));
+
+      _mm_storeu_ps (&shade[j], _mm_blendv_ps (cosine, min_shade, bad));
+    }
+
+  return (j);
+}
+
+#endif
+
+
+
+/***************************************************************************\
+*                                                                           *
+*   Module Name:        sunshade_row                                        *
+*                                                                           *
+*   Programmer(s):      PFM Software                                        *
+*                                                                           *
+*   Date Written:       October 2026                                        *
+*                                                                           *
+*   Purpose:            Compute the sunshade factor for every cell of a     *
+*                       row in one call so that the render loop doesn't     *
+*                       have to call nvutility's sunshade once per pixel.   *
+*                       Uses AVX-512, AVX2, or SSE4.1 (picked at run time)  *
+*                       with a scalar tail.                                 *
+*                                                                           *
+*   Arguments:          lower_row   -   adjacent row (same as sunshade)     *
+*                       upper_row   -   row being shaded                    *
+*                       width       -   number of cells in the rows         *
+*                       sunopts     -   sun options                         *
+*                       x_cell_size -   X cell size                         *
+*                       y_cell_size -   Y cell size                         *
+*                       null_value  -   values >= this are null             *
+*                       shade       -   shade factors (width values)        *
+*                                                                           *
+*   Return Value:       None                                                *
+*                                                                           *
+*   Caveats:            Negative (or NaN) factors and null cells are set    *
+*                       to sunopts->min_shade.  The last column has no      *
+*                       column to its east so it is shaded as if the        *
+*                       surface were flat in X.  If sunopts->power_cos      *
+*                       isn't 1.0 the factors are raised to that power.     *
+*                                                                           *
+\***************************************************************************/
+
+void sunshade_row (float *lower_row, float *upper_row, int32_t width, SUN_OPT *sunopts, double x_cell_size,
+                   double y_cell_size, float null_value, float *shade)
+{
+  SHADE_CONST         sc;
+  int32_t             j = 0, count;
+
+
+  if (width <= 0) return;
+
+
+  sc.exag = (float) sunopts->exag;
+  sc.dx = (float) x_cell_size;
+  sc.dy = (float) y_cell_size;
+  sc.nz2 = (sc.dx * sc.dy) * (sc.dx * sc.dy);
+  sc.sun_x = (float) sunopts->sun.x;
+  sc.sun_y = (float) sunopts->sun.y;
+  sc.sun_nz = (sc.dx * sc.dy) * (float) sunopts->sun.z;
+  sc.min_shade = sunopts->min_shade;
+  sc.null_value = null_value;
+
+
+  //  Every cell but the last one has a neighbor to the east in the row.
+
+  count = width - 1;
+
+
+#ifdef SUNSHADE_ROW_X86
+
+  if (__builtin_cpu_supports ("avx512f"))
+    {
+      j = shade_avx512 (lower_row, upper_row, count, &sc, shade);
+    }
+  else if (__builtin_cpu_supports ("avx2"))
+    {
+      j = shade_avx2 (lower_row, upper_row, count, &sc, shade);
+    }
+  else if (__builtin_cpu_supports ("sse4.1"))
+    {
+      j = shade_sse4 (lower_row, upper_row, count, &sc, shade);
+    }
+
+#endif
+
+
+  for ( ; j < count ; j++) shade[j] = shade_one (upper_row[j], upper_row[j + 1], lower_row[j], &sc);
+
+  shade[count] = shade_one (upper_row[count], upper_row[count], lower_row[count], &sc);
+
+
+  if (sunopts->power_cos != 1.0)
+    {
+      for (j = 0 ; j < width ; j++)
+        {
+          if (shade[j] > 0.0) shade[j] = powf (shade[j], (float) sunopts->power_cos);
+        }
+    }
+}
@@ -81,6 +81,42 @@ surfacePage::surfacePage (QWidget *parent, OPTIONS *op):
   fBoxLayout->addWidget (cBox);
 
 
+  QGroupBox *czBox = new QGroupBox (tr ("Compression"), this);
+  QHBoxLayout *czBoxLayout = new QHBoxLayout;
+  czBox->setLayout (czBoxLayout);
+  codec = new QComboBox (czBox);
+  codec->setToolTip (tr ("Compression codec (ignored for Caris format)"));
+  codec->setWhatsThis (codecText);
+  codec->setEditable (false);
+  codec->addItem (tr ("LZW"));
+  codec->addItem (tr ("DEFLATE"));
+  codec->addItem (tr ("ZSTD"));
+  codec->addItem (tr ("LZMA"));
+  codec->setCurrentIndex (options->codec);
+  connect (codec, SIGNAL (currentIndexChanged (int)), this, SLOT (slotCodecChanged (int)));
+  czBoxLayout->addWidget (codec);
+
+  codec_level = new QSpinBox (czBox);
+  codec_level->setSpecialValueText (tr ("Default"));
+  codec_level->setToolTip (tr ("Compression level (higher is smaller but slower)"));
+  codec_level->setWhatsThis (codecText);
+  czBoxLayout->addWidget (codec_level);
+  fBoxLayout->addWidget (czBox);
+  slotCodecChanged (options->codec);
+  codec_level->setValue (options->codec_level);
+
+
+  QGroupBox *coBox = new QGroupBox (tr ("Cloud Optimized"), this);
+  QHBoxLayout *coBoxLayout = new QHBoxLayout;
+  coBox->setLayout (coBoxLayout);
+  cog_check = new QCheckBox (coBox);
+  cog_check->setToolTip (tr ("Output a Cloud Optimized GeoTIFF (COG)"));
+  cog_check->setWhatsThis (cogText);
+  cog_check->setChecked (options->cog);
+  coBoxLayout->addWidget (cog_check);
+  fBoxLayout->addWidget (coBox);
+
+
   QGroupBox *gBox = new QGroupBox (tr ("32 bit grey scale GeoTIFF"), this);
   QHBoxLayout *gBoxLayout = new QHBoxLayout;
   gBox->setLayout (gBoxLayout);
@@ -92,6 +128,54 @@ surfacePage::surfacePage (QWidget *parent, OPTIONS *op):
   fBoxLayout->addWidget (gBox);
 
 
+  QGroupBox *tiBox = new QGroupBox (tr ("Tiled"), this);
+  QHBoxLayout *tiBoxLayout = new QHBoxLayout;
+  tiBox->setLayout (tiBoxLayout);
+  tiled_check = new QCheckBox (tiBox);
+  tiled_check->setToolTip (tr ("Write a tiled GeoTIFF instead of a striped GeoTIFF"));
+  tiled_check->setWhatsThis (tiledText);
+  tiled_check->setChecked (options->tiled);
+  tiBoxLayout->addWidget (tiled_check);
+
+  tile_size = new QSpinBox (tiBox);
+  tile_size->setRange (16, 4096);
+  tile_size->setSingleStep (16);
+  tile_size->setValue (options->tile_width);
+  tile_size->setToolTip (tr ("Width and height of the tiles in pixels (multiple of 16)"));
+  tile_size->setWhatsThis (tiledText);
+  tiBoxLayout->addWidget (tile_size);
+  fBoxLayout->addWidget (tiBox);
+
+
+  QGroupBox *ovBox = new QGroupBox (tr ("Overviews"), this);
+  QHBoxLayout *ovBoxLayout = new QHBoxLayout;
+  ovBox->setLayout (ovBoxLayout);
+  overviews_check = new QCheckBox (ovBox);
+  overviews_check->setToolTip (tr ("Build internal overviews (reduced resolution copies) while writing the GeoTIFF"));
+  overviews_check->setWhatsThis (overviewsText);
+  overviews_check->setChecked (options->overviews);
+  ovBoxLayout->addWidget (overviews_check);
+
+  ov_color_resampling = new QComboBox (ovBox);
+  ov_color_resampling->setToolTip (tr ("Resampling method for color overviews"));
+  ov_color_resampling->setWhatsThis (ovResamplingText);
+  ov_color_resampling->setEditable (false);
+  ov_color_resampling->addItem (tr ("Color nearest"));
+  ov_color_resampling->addItem (tr ("Color average"));
+  ov_color_resampling->setCurrentIndex (options->ov_color_resampling);
+  ovBoxLayout->addWidget (ov_color_resampling);
+
+  ov_grey_resampling = new QComboBox (ovBox);
+  ov_grey_resampling->setToolTip (tr ("Resampling method for 32 bit grey scale overviews"));
+  ov_grey_resampling->setWhatsThis (ovResamplingText);
+  ov_grey_resampling->setEditable (false);
+  ov_grey_resampling->addItem (tr ("Grey nearest"));
+  ov_grey_resampling->addItem (tr ("Grey average"));
+  ov_grey_resampling->setCurrentIndex (options->ov_grey_resampling);
+  ovBoxLayout->addWidget (ov_grey_resampling);
+  fBoxLayout->addWidget (ovBox);
+
+
   vbox->addWidget (fBox);
 
 
@@ -135,9 +219,19 @@ surfacePage::surfacePage (QWidget *parent, OPTIONS *op):
   interval->setSingleStep (20.0);
   interval->setWrapping (true);
   interval->setValue (options->cint);
-  interval->setToolTip (tr ("Set the contour interval for an ESRI SHAPE file"));
+  interval->setToolTip (tr ("Set the contour interval for the contour file"));
   interval->setWhatsThis (intervalText);
   iBoxLayout->addWidget (interval);
+
+  contour_format = new QComboBox (iBox);
+  contour_format->setToolTip (tr ("Contour file format"));
+  contour_format->setWhatsThis (contourFormatText);
+  contour_format->setEditable (false);
+  contour_format->addItem (tr ("Shapefile"));
+  contour_format->addItem (tr ("GeoPackage"));
+  contour_format->addItem (tr ("FlatGeobuf"));
+  contour_format->setCurrentIndex (options->contour_format);
+  iBoxLayout->addWidget (contour_format);
   oBoxLayout->addWidget (iBox);
 
 
@@ -155,12 +249,118 @@ surfacePage::surfacePage (QWidget *parent, OPTIONS *op):
   vbox->addWidget (oBox);
 
 
+  QGroupBox *pBox = new QGroupBox (tr ("Performance options"), this);
+  QHBoxLayout *pBoxLayout = new QHBoxLayout;
+  pBox->setLayout (pBoxLayout);
+
+  QGroupBox *thBox = new QGroupBox (tr ("Threads"), this);
+  QHBoxLayout *thBoxLayout = new QHBoxLayout;
+  thBox->setLayout (thBoxLayout);
+  threads = new QSpinBox (thBox);
+  threads->setRange (0, 64);
+  threads->setSpecialValueText (tr ("All cores"));
+  threads->setValue (options->num_threads);
+  threads->setToolTip (tr ("Number of threads used to sunshade and color the GeoTIFF (0 for all cores)"));
+  threads->setWhatsThis (threadsText);
+  thBoxLayout->addWidget (threads);
+  pBoxLayout->addWidget (thBox);
+
+
+  QGroupBox *ctBox = new QGroupBox (tr ("Compression threads"), this);
+  QHBoxLayout *ctBoxLayout = new QHBoxLayout;
+  ctBox->setLayout (ctBoxLayout);
+  compress_threads = new QSpinBox (ctBox);
+  compress_threads->setRange (0, 64);
+  compress_threads->setSpecialValueText (tr ("All cores"));
+  compress_threads->setValue (options->compress_threads);
+  compress_threads->setToolTip (tr ("Number of threads GDAL uses to compress the GeoTIFF (0 for all cores)"));
+  compress_threads->setWhatsThis (compressThreadsText);
+  ctBoxLayout->addWidget (compress_threads);
+  pBoxLayout->addWidget (ctBox);
+
+
+  QGroupBox *sBox = new QGroupBox (tr ("Low memory"), this);
+  QHBoxLayout *sBoxLayout = new QHBoxLayout;
+  sBox->setLayout (sBoxLayout);
+  stream_check = new QCheckBox (sBox);
+  stream_check->setToolTip (tr ("Stream the grid instead of loading all of it into memory"));
+  stream_check->setWhatsThis (streamText);
+  stream_check->setChecked (options->stream);
+  sBoxLayout->addWidget (stream_check);
+  pBoxLayout->addWidget (sBox);
+
+
+  QGroupBox *gcBox = new QGroupBox (tr ("Grid cache"), this);
+  QHBoxLayout *gcBoxLayout = new QHBoxLayout;
+  gcBox->setLayout (gcBoxLayout);
+  grid_cache_check = new QCheckBox (gcBox);
+  grid_cache_check->setToolTip (tr ("Save the loaded grid so the next run on the same file can skip reading it"));
+  grid_cache_check->setWhatsThis (gridCacheText);
+  grid_cache_check->setChecked (options->grid_cache);
+  gcBoxLayout->addWidget (grid_cache_check);
+  pBoxLayout->addWidget (gcBox);
+
+
+  QGroupBox *siBox = new QGroupBox (tr ("Statistics index"), this);
+  QHBoxLayout *siBoxLayout = new QHBoxLayout;
+  siBox->setLayout (siBoxLayout);
+  stats_index_check = new QCheckBox (siBox);
+  stats_index_check->setToolTip (tr ("Get the minimum and maximum from a block statistics index file next to the CHRTR file"));
+  stats_index_check->setWhatsThis (statsIndexText);
+  stats_index_check->setChecked (options->stats_index);
+  siBoxLayout->addWidget (stats_index_check);
+  pBoxLayout->addWidget (siBox);
+
+
+  vbox->addWidget (pBox);
+
+
   registerField ("transparent_check", transparent_check);
   registerField ("caris_check", caris_check);
   registerField ("grey_check", grey_check);
+  registerField ("cog_check", cog_check);
+  registerField ("codec_level", codec_level, "value");
+  registerField ("tiled_check", tiled_check);
+  registerField ("tile_size", tile_size, "value");
+  registerField ("overviews_check", overviews_check);
+  registerField ("ov_color_resampling", ov_color_resampling, "currentIndex");
+  registerField ("ov_grey_resampling", ov_grey_resampling, "currentIndex");
   registerField ("elev_check", elev_check);
   registerField ("dumb_check", dumb_check);
   registerField ("interval", interval, "value");
+  registerField ("contour_format", contour_format, "currentIndex");
+  registerField ("threads", threads, "value");
+  registerField ("compress_threads", compress_threads, "value");
+  registerField ("stream_check", stream_check);
+  registerField ("grid_cache_check", grid_cache_check);
+  registerField ("stats_index_check", stats_index_check);
+}
+
+
+
+//!  Set the level range for the selected codec.  LZW doesn't have levels.
+
+void surfacePage::slotCodecChanged (int index)
+{
+  options->codec = index;
+
+  switch (options->codec)
+    {
+    case CODEC_LZW:
+      codec_level->setRange (0, 0);
+      break;
+
+    case CODEC_DEFLATE:
+    case CODEC_LZMA:
+      codec_level->setRange (0, 9);
+      break;
+
+    case CODEC_ZSTD:
+      codec_level->setRange (0, 22);
+      break;
+    }
+
+  codec_level->setEnabled (options->codec != CODEC_LZW);
 }
 
 
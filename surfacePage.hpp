@@ -60,16 +60,20 @@ protected:
 
   OPTIONS          *options;
 
-  QCheckBox        *transparent_check, *caris_check, *grey_check, *dumb_check, *elev_check;
+  QCheckBox        *transparent_check, *caris_check, *grey_check, *dumb_check, *elev_check, *stream_check, *tiled_check;
+  QCheckBox        *overviews_check, *cog_check, *grid_cache_check, *stats_index_check;
 
-  QComboBox        *units;
+  QComboBox        *units, *contour_format, *ov_color_resampling, *ov_grey_resampling;
 
   QDoubleSpinBox   *interval;
 
+  QSpinBox         *threads, *tile_size, *compress_threads, *codec_level;
+
 
 protected slots:
 
   void slotUnitsChanged (int index);
+  void slotCodecChanged (int index);
 
 
 private:
@@ -51,6 +51,45 @@ QString carisText =
                    "don't use it!  If you must use it, make sure that your output file is on a local disk "
                    "not an NFS mounted disk (/net/whatever).");
 
+QString codecText = 
+  surfacePage::tr ("Select the compression codec and level for the GeoTIFF.  <b>LZW</b> is the old default and can be read by "
+                   "just about anything.  <b>DEFLATE</b>, <b>ZSTD</b>, and <b>LZMA</b> use the horizontal differencing predictor "
+                   "(floating point predictor for 32 bit output) which makes the files much smaller.  <b>ZSTD</b> is much faster to "
+                   "write and to read than <b>LZW</b> but older software (GDAL before 2.3) can't read it.  <b>LZMA</b> makes the "
+                   "smallest files but is slow.  The level sets the trade off between size and speed (DEFLATE and LZMA 1 to 9, "
+                   "ZSTD 1 to 22), <b>Default</b> uses the codec's default level.  This option is ignored if you select "
+                   "<b>Caris Format</b>.");
+
+QString cogText = 
+  surfacePage::tr ("Checking this box will cause the output to be written as a Cloud Optimized GeoTIFF (COG).  A COG is a tiled, "
+                   "LZW compressed GeoTIFF with internal overviews that has all of its directories at the front of the file so "
+                   "a viewer can open it over HTTP (using range requests) by reading just a few KB.  The tile size is taken "
+                   "from the <b>Tiled</b> tile size.  The file is written in a single pass but, since the overviews have to be "
+                   "computed first, the image is sunshaded twice so this is a bit slower than a normal GeoTIFF.  Building the "
+                   "overviews can be turned off with the <b>Overviews</b> check box.  This option overrides <b>Caris Format</b> "
+                   "and requires GDAL 3.1 or newer.");
+
+QString tiledText = 
+  surfacePage::tr ("Checking this box will cause the GeoTIFF to be written in square tiles of the selected size instead of in strips "
+                   "of rows.  Viewers (like <b>pfmView</b>, <b>qGIS</b>, or <b>CARIS</b>) can then read and decompress just the tiles "
+                   "they need when you pan and zoom instead of whole strips.  The tile size must be a multiple of 16.  This option is "
+                   "ignored if you select <b>Caris Format</b>.");
+
+QString overviewsText = 
+  surfacePage::tr ("Checking this box will cause internal overviews (copies of the image at 1/2, 1/4, 1/8, ... resolution) to be "
+                   "built while the GeoTIFF is being written.  Viewers use the overviews when you zoom out so they don't have to "
+                   "read the entire image.  You won't need to run <b>gdaladdo</b> on the file afterwards.  The resampling method "
+                   "for color and 32 bit floating point output is set with the two menus next to the check box.  This option "
+                   "is ignored if you select <b>Caris Format</b>.");
+
+QString ovResamplingText = 
+  surfacePage::tr ("Select how the overview pixels are made from the full resolution pixels.  <b>Nearest</b> uses the pixel at "
+                   "the center of each block so the overview colors are colors that are in the image.  <b>Average</b> averages "
+                   "the block.  Empty cells are left out of the average for 32 bit floating point and transparent output but "
+                   "in color output without a transparent background the empty cells are black and they get averaged in, "
+                   "darkening the edges of the data.  The default is <b>Nearest</b> for color and <b>Average</b> for 32 bit "
+                   "floating point.");
+
 QString greyText = 
   surfacePage::tr ("This check box will force the output to be 32 bit floating point elevation values.  When checked, the transparent "
                    "option is ignored and the color setting page will be disabled.<br><br>"
@@ -78,4 +117,53 @@ QString intervalText =
   surfacePage::tr ("Select a contour interval for use in generating an ESRI SHAPE file containing the contours.  If you set this value to 0.0 "
                    "no contour files will be generated.  Contours will be in the units selected for the geoTIFF.  The name of the ESRI SHAPE file "
                    "will be the same as the geoTIFF file but with a .shp extension.  There will also be a .shx, .dbf, and .prj file "
-                   "generated.");
+                   "generated.  See <b>Contour file format</b> for the other formats.");
+
+QString contourFormatText = 
+  surfacePage::tr ("Select the format of the contour file.  <b>Shapefile</b> writes an ESRI SHAPE file (.shp, .shx, .dbf, and .prj) "
+                   "which can't be bigger than 2GB and has no spatial index.  <b>GeoPackage</b> (.gpkg) and <b>FlatGeobuf</b> (.fgb) "
+                   "are single files with a spatial index so a viewer can load the contours for the area it's showing without "
+                   "reading the whole file.  Each contour has a <i>level</i> field.  This option is only used when the contour "
+                   "interval isn't 0.0.");
+
+QString threadsText = 
+  surfacePage::tr ("Set the number of threads used to sunshade and color the GeoTIFF.  The image is split into bands of rows and each "
+                   "thread works on its own band.  The bands are always written in order so the output is the same no matter how many "
+                   "threads are used.  Set this to <b>All cores</b> (0) to use one thread per core.  This option has no effect on "
+                   "32 bit floating point output since there is no sunshading or coloring to do.");
+
+QString compressThreadsText = 
+  surfacePage::tr ("Set the number of threads GDAL uses to compress the GeoTIFF.  Each tile (or strip) is compressed on its "
+                   "own so the compressed data is exactly the same no matter how many threads are used.  Set this to "
+                   "<b>All cores</b> (0) to use one thread per core or to 1 to compress on the writing thread.");
+
+QString streamText = 
+  surfacePage::tr ("Checking this box will keep the program from loading the entire CHRTR grid into memory.  The file will be read once "
+                   "to get the minimum and maximum values and then read again, a few rows at a time, while the GeoTIFF is being "
+                   "written.  This is a little slower than loading the grid but the memory used depends only on the width of the grid "
+                   "so you can convert grids that are much larger than the memory in your computer.<br><br>"
+                   "<b>IMPORTANT NOTE: Contouring needs the entire grid so this option is ignored if you set a contour interval.  If "
+                   "there isn't enough memory to load the grid and you aren't contouring, this mode will be used automatically.</b>");
+
+QString gridCacheText = 
+  surfacePage::tr ("Checking this box will save the loaded grid (after the area file, units, and depth/elevation have been "
+                   "applied), along with its minimum and maximum values, in a cache file.  The next time the same CHRTR file is "
+                   "converted with the same area file, units, and depth/elevation settings the cached grid is mapped straight "
+                   "into memory instead of being read and converted again.  This makes it quick to try different colors or "
+                   "sunshading on the same data.<br><br>"
+                   "The cache files are the size of the grid (4 bytes per cell) and are kept in the ABE.config/chrtrGeotiffCache "
+                   "folder in your home directory.  A cache file is only used if the CHRTR file hasn't changed since it was "
+                   "cached.  Cache files for older versions of a CHRTR file are removed when a new one is saved.  You may "
+                   "delete any of the cache files at any time.");
+
+QString statsIndexText = 
+  surfacePage::tr ("Checking this box will get the minimum and maximum values used for the color ranges from a statistics "
+                   "index file instead of reading every row of the grid.  The index file is stored next to the CHRTR file (with "
+                   ".stats added to the name) and holds the minimum, maximum, count, sum, and a coarse histogram of each 256 by 256 "
+                   "cell block of the file.  The first time a file is converted with this option set the whole file is read "
+                   "once to build the index.  After that, only the cells of the blocks along the edges of the area file (if "
+                   "any) are read.  The minimum and maximum are exactly the same as they would be without the index.  The "
+                   "index is only used in <b>Low memory mode</b>, otherwise the grid is already in memory and scanning it is "
+                   "faster.<br><br>"
+                   "The index is rebuilt if the CHRTR file changes.  If the folder holding the CHRTR file can't be written "
+                   "the index is built for each run but not saved.");
@@ -39,7 +39,7 @@
 
 #ifndef VERSION
 
-#define     VERSION     "PFM Software - chrtrGeotiff V2.14 - 08/07/19"
+#define     VERSION     "PFM Software - chrtrGeotiff V3.00 - 10/16/26"
 
 #endif
 
@@ -177,4 +177,93 @@
     - Now that get_area_mbr supports shape files we don't need to handle it differently from the other
       area file types.
 
+
+    Version 3.00
+    PFM Software
+    10/16/26
+
+    - Added --batch command line mode that converts one or more CHRTR/CHRTR2 files without building the wizard.
+    - Fixed reading past the end of the grid array when an area file moved the southern edge off of row 0.
+    - Moved the conversion into a GUI free chrtrRenderEngine class with separate open, load, stats, createOutput,
+      render, and contour stages.  Progress is reported through a callback interface and errors are returned
+      as codes instead of calling exit so one bad file won't kill a batch run.
+    - Sunshading and coloring of the GeoTIFF is now done in bands of rows on a configurable number of threads.
+      The bands are written in order so the output doesn't depend on the thread count.
+    - Added a low memory (streaming) option.  When not contouring, the grid is read once for the min/max and
+      again, a chunk at a time, while the GeoTIFF is written so memory use no longer depends on the grid height.
+    - Input now goes through chrtrReader which, on Linux, asks the kernel (posix_fadvise) to read ahead of the rows
+      we're reading (in either direction).  The rows are still decoded by the CHRTR/CHRTR2 libraries and a reader
+      has one file handle so each thread that reads at the same time needs its own.  This is only a read ahead
+      hint, the file isn't memory mapped.  Rows can't be decoded from a mapping without the CHRTR2 record layout
+      and, reading a 2GB file with a cold cache, copying rows out of a mapping was slower than reading them (about
+      twice as slow going forward and eight times as slow going backward).
+    - Added tiled GeoTIFF output with a configurable tile size.  The render stage writes whole tile rows per call.
+    - Colors are rendered into one packed, pixel interleaved, RGB(A) buffer and written with a single dataset
+      RasterIO call per chunk instead of one call per band.
+    - The render loop looks colors up in a packed 32 bit RGBA table built once per run instead of calling the
+      QColor accessors for every pixel.
+    - Added sunshade_row which shades a whole row at a time (AVX-512, AVX2, or SSE4.1, picked at run time, with a
+      scalar tail) instead of calling sunshade for every pixel.  Used for the GeoTIFF and for the sample image.
+      Every version does the same single precision operations in the same order (built with -ffp-contract=off)
+      so the shading doesn't depend on the CPU.
+    - Added color_index_row which turns a row of Z values and shade factors into color table indices in one
+      vectorized pass (multiplying by precomputed NUMHUES / range values instead of dividing for every pixel).
+      The scalar tail and the AVX2 and SSE4.1 versions round the shade in single precision the same way so every
+      version gives the same index.
+    - Added internal overviews (2x, 4x, 8x, ...) built from the rendered rows while the GeoTIFF is written, one
+      thread per level.  Overviews are off by default.  Color overviews default to nearest neighbor (averaging
+      blends the black empty cells of non-transparent output into the data), grey scale overviews default to
+      averaging that ignores empty cells.  Both can be changed on the surface page or with --overview-color and
+      --overview-grey.
+    - Added Cloud Optimized GeoTIFF output.  GDAL's COG driver reads the image from a virtual dataset
+      (renderDataset) that renders blocks as they're read so the file is written in one pass with no
+      intermediate GeoTIFF.
+    - The render stage is now a pipeline (a reader thread, render worker threads, and the writer) joined by
+      queues of blocks from a fixed size pool so reading, shading, and compressing overlap without using more
+      memory as the grid gets bigger.
+    - Added a compression threads option.  GDAL compresses the tiles (or strips) on a pool of threads
+      (NUM_THREADS) and the compressed data is the same as compressing on one thread.
+    - Added DEFLATE, ZSTD, and LZMA compression (with the horizontal differencing predictor for color and the
+      floating point predictor for 32 bit output) and a compression level option.  LZW is still the default.
+    - Large outputs are written as BigTIFF.  The size is estimated from the width, height, bands, and data type
+      before the file is created instead of failing at 4GB after the grid has been loaded and half rendered.
+    - Replaced the contouring package with contourEngine.  The grid is split into tiles that are traced (marching
+      squares) on a pool of threads and the lines are stitched across the tile seams by matching the keys of the
+      grid edges they end on.  The lines are put in a standard order so the output is the same for any number of
+      threads.  Cells with a null corner are not contoured.  The contour files are not the same as the ones the
+      old package wrote.  The levels are the same but the lines are written in a different order, may start at
+      different points, and aren't traced into cells with a null corner, so compare them by drawing them, not by
+      diffing the files.  The contour count in the messages is now the number of lines.
+    - contourEngine classifies the grid points against each level 64 at a time into bitmaps (AVX2 or SSE2 compares)
+      and skips cells with no crossing a word at a time.  Lines are followed from cell to cell with a visited edge
+      bitmap instead of being built from per cell segments and sorted together.
+    - contourEngine does one level at a time and hands each level's lines to scribe as soon as they're finished
+      so only one level's points are in memory.  The points are kept in std::vectors with 64 bit offsets.
+    - Contours are written with shapeWriter which builds the .shp, .shx, and .dbf records in large memory buffers,
+      writes them sequentially, and fills in the headers when the files are closed instead of using shapelib's
+      per record seeks and writes.
+    - Added a contour file format option.  Contours can be written to a GeoPackage (with an R-tree) or a FlatGeobuf
+      file (with a packed Hilbert R-tree) through OGR, committing every 10000 features, as well as a shape file.
+      Each contour has a level field.
+    - Each contour is now written as one object no matter how long it is instead of in 1000 point pieces.  The
+      point buffers are reused from contour to contour and grow when a contour doesn't fit.  Contours with more
+      than 50,000,000 points are split into several objects that share their end points, and shapeWriter stops
+      with an error instead of writing a shape file bigger than 2GB.
+    - The area file now masks the output instead of just setting its bounds.  All of the shapes (and parts) in an
+      area shape file are used, not just the first one.  The polygons are rasterized with an edge table scanline
+      fill into spans of inside cells for each row and cells outside of them are set to null as the rows are read
+      so they aren't shaded, colored, or contoured.  Rows that are completely outside aren't read.
+    - Added a grid cache option.  The loaded grid (after the area mask, units, and depth/elevation) and its min/max
+      are saved in a file in ABE.config/chrtrGeotiffCache named from a hash of the CHRTR file's path, modification
+      time, and size, the area file, the window, and the units, dumb, and elev options.  The next run with the same
+      key maps the file in instead of reading and converting the CHRTR file and scanning it for the min/max.
+    - Added a statistics index option.  The min, max, count, sum, and a coarse (signed octave) histogram of every
+      256 by 256 block of the CHRTR file are saved in a .stats file next to it the first time it's converted.
+      After that the min/max for the output window are put together from the blocks inside of it, reading only
+      the cells of the blocks along the edges of the window (or of the area polygons).  The index is only used
+      when streaming, an in memory grid is just scanned.
+    - Added a preview of the input file to the image page.  A reduced copy of the grid is read on a background
+      thread (coarse first, then finer) and shaded with the current settings so the image sharpens as it comes
+      in.  Changing a setting cancels the thread and reshades the copies it has already read.
+
 </pre>*/